@@ -0,0 +1,150 @@
+// Compressed ingest decode (per-session AudioDecoder) and FLAC recording encode, reported
+// as realtime streams per core
+
+#include <algorithm>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#ifdef BOWW_HAVE_OPUS
+    #include <opus/opus.h>
+#endif
+#ifdef BOWW_HAVE_FLAC
+    #include <FLAC/stream_encoder.h>
+#endif
+
+#include "BenchUtil.h"
+#include "AudioDecoder.h"
+#include "AsyncFileWriter.h"
+#include "BoWWServerDefs.h"
+
+namespace boww {
+namespace bench {
+
+    // Encoded test signal, one packet per frame
+    using Packets = std::vector<std::vector<uint8_t>>;
+
+    // streams_per_core: seconds of audio coded per CPU second, i.e. realtime streams one core can take
+    static void ReportStreamCost(benchmark::State& state, size_t samples_per_iter, int sample_rate = DEFAULT_SAMPLE_RATE) {
+        double audio_s = static_cast<double>(samples_per_iter) * state.iterations() / sample_rate;
+        state.counters["streams_per_core"] = benchmark::Counter(audio_s, benchmark::Counter::kIsRate);
+        state.SetItemsProcessed(static_cast<int64_t>(samples_per_iter) * state.iterations());
+    }
+
+    static void BM_DecodeAdpcm(benchmark::State& state) {
+        const size_t frame = static_cast<size_t>(state.range(0));
+        auto x = TestAudio(frame * 50);
+        Packets packets;
+        adpcm::EncoderState enc;
+        for (size_t pos = 0; pos + frame <= x.size(); pos += frame) {
+            std::vector<uint8_t> p(adpcm::EncodedSize(frame));
+            p.resize(adpcm::Encode(x.data() + pos, frame, p.data(), enc));
+            packets.push_back(std::move(p));
+        }
+
+        AudioDecoder decoder(IngestCodec::IMA_ADPCM, DEFAULT_SAMPLE_RATE, DEFAULT_CHANNELS);
+        std::vector<int16_t> out;
+        out.reserve(frame);
+        size_t i = 0;
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            out.clear();
+            decoder.Decode(packets[i].data(), packets[i].size(), out);
+            benchmark::DoNotOptimize(out.data());
+            i = (i + 1) % packets.size();
+        }
+        ReportStreamCost(state, frame);
+    }
+    BENCHMARK(BM_DecodeAdpcm)->Arg(320)->Arg(1024);
+
+#ifdef BOWW_HAVE_OPUS
+    // Frame sizes in samples at 16 kHz: 20 ms and 60 ms; range(1) is the bitrate
+    static void BM_DecodeOpus(benchmark::State& state) {
+        const int frame = static_cast<int>(state.range(0));
+        auto x = TestAudio(static_cast<size_t>(frame) * 50);
+
+        int err = OPUS_OK;
+        OpusEncoder* enc = opus_encoder_create(DEFAULT_SAMPLE_RATE, DEFAULT_CHANNELS, OPUS_APPLICATION_VOIP, &err);
+        if (err != OPUS_OK) {
+            state.SkipWithError("opus_encoder_create failed");
+            return;
+        }
+        opus_encoder_ctl(enc, OPUS_SET_BITRATE(static_cast<opus_int32>(state.range(1))));
+        Packets packets;
+        for (size_t pos = 0; pos + frame <= x.size(); pos += frame) {
+            std::vector<uint8_t> p(1500);
+            int n = opus_encode(enc, x.data() + pos, frame, p.data(), static_cast<opus_int32>(p.size()));
+            if (n <= 0) break;
+            p.resize(static_cast<size_t>(n));
+            packets.push_back(std::move(p));
+        }
+        opus_encoder_destroy(enc);
+        if (packets.empty()) {
+            state.SkipWithError("opus_encode failed");
+            return;
+        }
+
+        AudioDecoder decoder(IngestCodec::OPUS, DEFAULT_SAMPLE_RATE, DEFAULT_CHANNELS);
+        std::vector<int16_t> out;
+        out.reserve(DEFAULT_SAMPLE_RATE * 120 / 1000);
+        size_t i = 0;
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            out.clear();
+            decoder.Decode(packets[i].data(), packets[i].size(), out);
+            benchmark::DoNotOptimize(out.data());
+            i = (i + 1) % packets.size();
+        }
+        ReportStreamCost(state, static_cast<size_t>(frame));
+    }
+    BENCHMARK(BM_DecodeOpus)->Args({320, 24000})->Args({960, 24000})->Args({320, 48000});
+#endif
+
+#ifdef BOWW_HAVE_FLAC
+    // The writer thread's FLAC encode, same settings and chunking as AsyncFileWriter, into a
+    // byte counter instead of a file. range(0) is the group rate, range(1) its channels.
+    static void BM_EncodeFlac(benchmark::State& state) {
+        const int rate = static_cast<int>(state.range(0));
+        const int channels = static_cast<int>(state.range(1));
+        const size_t chunk = AsyncFileWriter::kEncodeFrames * channels;
+        auto x = TestAudio(chunk * 16);
+
+        FLAC__StreamEncoder* enc = FLAC__stream_encoder_new();
+        if (!enc) {
+            state.SkipWithError("FLAC__stream_encoder_new failed");
+            return;
+        }
+        FLAC__stream_encoder_set_channels(enc, channels);
+        FLAC__stream_encoder_set_bits_per_sample(enc, 16);
+        FLAC__stream_encoder_set_sample_rate(enc, rate);
+        FLAC__stream_encoder_set_compression_level(enc, AsyncFileWriter::kFlacCompressionLevel);
+        FLAC__stream_encoder_set_verify(enc, false);
+        uint64_t encoded_bytes = 0;
+        auto count_bytes = [](const FLAC__StreamEncoder*, const FLAC__byte[], size_t bytes, uint32_t, uint32_t, void* client_data) {
+            *static_cast<uint64_t*>(client_data) += bytes;
+            return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+        };
+        if (FLAC__stream_encoder_init_stream(enc, count_bytes, nullptr, nullptr, nullptr, &encoded_bytes) !=
+            FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+            FLAC__stream_encoder_delete(enc);
+            state.SkipWithError("FLAC__stream_encoder_init_stream failed");
+            return;
+        }
+
+        std::vector<int32_t> buf(chunk);
+        size_t pos = 0;
+        for (auto _ : state) {
+            for (size_t i = 0; i < chunk; ++i) buf[i] = x[pos + i];
+            FLAC__stream_encoder_process_interleaved(enc, buf.data(), static_cast<uint32_t>(AsyncFileWriter::kEncodeFrames));
+            pos = (pos + chunk) % x.size();
+        }
+        FLAC__stream_encoder_finish(enc);
+        FLAC__stream_encoder_delete(enc);
+
+        ReportStreamCost(state, AsyncFileWriter::kEncodeFrames, rate);
+        state.counters["compression_ratio"] = static_cast<double>(state.iterations() * chunk * sizeof(int16_t)) /
+                                              static_cast<double>(std::max<uint64_t>(1, encoded_bytes));
+    }
+    BENCHMARK(BM_EncodeFlac)->Args({16000, 1})->Args({48000, 2});
+#endif
+}
+}
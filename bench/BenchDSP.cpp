@@ -0,0 +1,306 @@
+// DSP kernels (dispatched SIMD vs scalar reference), playback mix, sidechain channel stage and resampler, AGC and ring buffers
+
+#include <cmath>
+#include <cstring>
+#include <benchmark/benchmark.h>
+
+#include "BenchUtil.h"
+#include "DSPKernels.h"
+#include "Resampler.h"
+#include "ChannelSelector.h"
+#include "SimpleAGC.h"
+#include "RingBuffer.h"
+#include "VADEngine.h"
+
+namespace boww {
+namespace bench {
+
+    // --- Kernels: SIMD path first checks it is bit-exact with scalar on the same input ---
+
+    static void BM_SumSquares(benchmark::State& state, bool simd) {
+        auto x = TestAudio(static_cast<size_t>(state.range(0)));
+        if (dsp::SumSquares(x.data(), x.size()) != dsp::scalar::SumSquares(x.data(), x.size())) {
+            state.SkipWithError("SIMD SumSquares differs from scalar");
+            return;
+        }
+        for (auto _ : state) {
+            uint64_t r = simd ? dsp::SumSquares(x.data(), x.size()) : dsp::scalar::SumSquares(x.data(), x.size());
+            benchmark::DoNotOptimize(r);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK_CAPTURE(BM_SumSquares, simd, true)->Arg(512)->Arg(4096);
+    BENCHMARK_CAPTURE(BM_SumSquares, scalar, false)->Arg(512)->Arg(4096);
+
+    static void BM_ScaleSaturate(benchmark::State& state, bool simd) {
+        auto x = TestAudio(static_cast<size_t>(state.range(0)));
+        std::vector<int16_t> a(x.size()), b(x.size());
+        dsp::ScaleSaturate(x.data(), a.data(), x.size(), 7.3f);     // Gain high enough to clip
+        dsp::scalar::ScaleSaturate(x.data(), b.data(), x.size(), 7.3f);
+        if (a != b) {
+            state.SkipWithError("SIMD ScaleSaturate differs from scalar");
+            return;
+        }
+        for (auto _ : state) {
+            if (simd) dsp::ScaleSaturate(x.data(), a.data(), x.size(), 0.4f);
+            else dsp::scalar::ScaleSaturate(x.data(), a.data(), x.size(), 0.4f);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK_CAPTURE(BM_ScaleSaturate, simd, true)->Arg(512)->Arg(4096);
+    BENCHMARK_CAPTURE(BM_ScaleSaturate, scalar, false)->Arg(512)->Arg(4096);
+
+    static void BM_Int16ToFloat(benchmark::State& state, bool simd) {
+        auto x = TestAudio(static_cast<size_t>(state.range(0)));
+        std::vector<float> a(x.size()), b(x.size());
+        dsp::Int16ToFloat(x.data(), a.data(), x.size());
+        dsp::scalar::Int16ToFloat(x.data(), b.data(), x.size());
+        if (std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) != 0) {
+            state.SkipWithError("SIMD Int16ToFloat differs from scalar");
+            return;
+        }
+        for (auto _ : state) {
+            if (simd) dsp::Int16ToFloat(x.data(), a.data(), x.size());
+            else dsp::scalar::Int16ToFloat(x.data(), a.data(), x.size());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK_CAPTURE(BM_Int16ToFloat, simd, true)->Arg(512);
+    BENCHMARK_CAPTURE(BM_Int16ToFloat, scalar, false)->Arg(512);
+
+    // FIR inner loop; float, so checked against scalar to a tolerance rather than bit-exact
+    static void BM_DotProduct(benchmark::State& state, bool simd) {
+        size_t n = static_cast<size_t>(state.range(0));
+        auto x = TestAudio(n * 2);
+        std::vector<float> a(n), b(n);
+        dsp::Int16ToFloat(x.data(), a.data(), n);
+        dsp::Int16ToFloat(x.data() + n, b.data(), n);
+        float fast = dsp::DotProduct(a.data(), b.data(), n);
+        float ref = dsp::scalar::DotProduct(a.data(), b.data(), n);
+        if (std::fabs(fast - ref) > 1e-4f * (1.0f + std::fabs(ref))) {
+            state.SkipWithError("SIMD DotProduct differs from scalar");
+            return;
+        }
+        for (auto _ : state) {
+            float r = simd ? dsp::DotProduct(a.data(), b.data(), n) : dsp::scalar::DotProduct(a.data(), b.data(), n);
+            benchmark::DoNotOptimize(r);
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+    BENCHMARK_CAPTURE(BM_DotProduct, simd, true)->Arg(120);
+    BENCHMARK_CAPTURE(BM_DotProduct, scalar, false)->Arg(120);
+
+    // range(0) = channels; 1024 interleaved frames
+    static void BM_Deinterleave(benchmark::State& state, bool simd) {
+        const int channels = static_cast<int>(state.range(0));
+        const size_t frames = 1024;
+        auto x = TestAudio(frames * channels);
+        std::vector<std::vector<int16_t>> a(channels, std::vector<int16_t>(frames)), b = a;
+        std::vector<int16_t*> pa, pb;
+        for (int c = 0; c < channels; ++c) { pa.push_back(a[c].data()); pb.push_back(b[c].data()); }
+        dsp::Deinterleave(x.data(), frames, channels, pa.data());
+        dsp::scalar::Deinterleave(x.data(), frames, channels, pb.data());
+        if (a != b) {
+            state.SkipWithError("SIMD Deinterleave differs from scalar");
+            return;
+        }
+        for (auto _ : state) {
+            if (simd) dsp::Deinterleave(x.data(), frames, channels, pa.data());
+            else dsp::scalar::Deinterleave(x.data(), frames, channels, pa.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * frames * channels);
+    }
+    BENCHMARK_CAPTURE(BM_Deinterleave, simd, true)->Arg(2)->Arg(4);
+    BENCHMARK_CAPTURE(BM_Deinterleave, scalar, false)->Arg(2)->Arg(4);
+
+    static void BM_Downmix(benchmark::State& state, bool simd) {
+        const int channels = static_cast<int>(state.range(0));
+        const size_t frames = 1024;
+        auto x = TestAudio(frames * channels);
+        std::vector<int16_t> a(frames), b(frames);
+        dsp::Downmix(x.data(), frames, channels, a.data());
+        dsp::scalar::Downmix(x.data(), frames, channels, b.data());
+        if (a != b) {
+            state.SkipWithError("SIMD Downmix differs from scalar");
+            return;
+        }
+        for (auto _ : state) {
+            if (simd) dsp::Downmix(x.data(), frames, channels, a.data());
+            else dsp::scalar::Downmix(x.data(), frames, channels, a.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * frames * channels);
+    }
+    BENCHMARK_CAPTURE(BM_Downmix, simd, true)->Arg(2)->Arg(4)->Arg(6);
+    BENCHMARK_CAPTURE(BM_Downmix, scalar, false)->Arg(2)->Arg(4)->Arg(6);
+
+    // One ALSA mixer period (10 ms of 48 kHz stereo) with range(0) sources, each at its own gain
+    static void BM_MixPeriod(benchmark::State& state, bool simd) {
+        const size_t sources = static_cast<size_t>(state.range(0));
+        const size_t n = 480 * 2;
+        auto x = TestAudio(n * sources);
+        std::vector<float> acc(n);
+        std::vector<int16_t> a(n), b(n);
+        auto mix = [&](bool use_simd, std::vector<int16_t>& out) {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            for (size_t s = 0; s < sources; ++s) {
+                float gain = 0.5f + 0.25f * static_cast<float>(s);    // Enough sources clip
+                if (use_simd) dsp::MixAccumulate(x.data() + s * n, acc.data(), n, gain);
+                else dsp::scalar::MixAccumulate(x.data() + s * n, acc.data(), n, gain);
+            }
+            if (use_simd) dsp::SaturateToInt16(acc.data(), out.data(), n);
+            else dsp::scalar::SaturateToInt16(acc.data(), out.data(), n);
+        };
+        mix(true, a);
+        mix(false, b);
+        if (a != b) {
+            state.SkipWithError("SIMD mix differs from scalar");
+            return;
+        }
+        for (auto _ : state) {
+            mix(simd, a);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * n * sources);
+    }
+    BENCHMARK_CAPTURE(BM_MixPeriod, simd, true)->Arg(1)->Arg(4)->Arg(8);
+    BENCHMARK_CAPTURE(BM_MixPeriod, scalar, false)->Arg(1)->Arg(4)->Arg(8);
+
+    // --- Sidechain channel stage: one VAD chunk's worth of frames (512 per channel) per iteration,
+    //     so the time compares directly with BM_VADProcess, i.e. with running one more VAD per channel ---
+
+    static void BM_ChannelSelect(benchmark::State& state, ChannelPolicy policy) {
+        const int channels = static_cast<int>(state.range(0));
+        auto x = TestAudio(VAD_CHUNK_SIZE * channels);
+        ChannelSelector selector(channels, policy, 0);
+        std::vector<int16_t> out;
+        out.reserve(selector.MaxOutput(x.size()));
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            out.clear();
+            selector.Process(x.data(), x.size(), out);
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetItemsProcessed(state.iterations() * x.size());
+    }
+    BENCHMARK_CAPTURE(BM_ChannelSelect, downmix, ChannelPolicy::DOWNMIX)->Arg(2)->Arg(4);
+    BENCHMARK_CAPTURE(BM_ChannelSelect, fixed, ChannelPolicy::FIXED)->Arg(2)->Arg(4);
+    BENCHMARK_CAPTURE(BM_ChannelSelect, best, ChannelPolicy::BEST)->Arg(2)->Arg(4)->Arg(8);
+
+    // --- Sidechain resampler: throughput, plus quality measured once on pure tones ---
+
+    static std::vector<int16_t> Tone(int rate, double hz, size_t samples) {
+        std::vector<int16_t> out(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            out[i] = static_cast<int16_t>(10000.0 * std::sin(2.0 * M_PI * hz * static_cast<double>(i) / rate));
+        }
+        return out;
+    }
+
+    // Power of the output left after removing the best-fit tone at hz, relative to the tone (dB)
+    static double ResidualDb(const std::vector<int16_t>& y, double hz, int rate, size_t skip) {
+        double re = 0.0, im = 0.0;
+        for (size_t i = skip; i < y.size(); ++i) {
+            double w = 2.0 * M_PI * hz * static_cast<double>(i) / rate;
+            re += y[i] * std::cos(w);
+            im += y[i] * std::sin(w);
+        }
+        re *= 2.0 / static_cast<double>(y.size() - skip);
+        im *= 2.0 / static_cast<double>(y.size() - skip);
+        double signal = 0.0, error = 0.0;
+        for (size_t i = skip; i < y.size(); ++i) {
+            double w = 2.0 * M_PI * hz * static_cast<double>(i) / rate;
+            double fit = re * std::cos(w) + im * std::sin(w);
+            signal += fit * fit;
+            error += (y[i] - fit) * (y[i] - fit);
+        }
+        return 10.0 * std::log10((error + 1e-9) / (signal + 1e-9));
+    }
+
+    static std::vector<int16_t> ResampleAll(int rate, const std::vector<int16_t>& x) {
+        Resampler r(rate, VAD_SAMPLE_RATE);
+        std::vector<int16_t> y;
+        for (size_t pos = 0; pos < x.size(); pos += 1000) r.Process(x.data() + pos, std::min<size_t>(1000, x.size() - pos), y);
+        return y;
+    }
+
+    // range(0) = input rate; frames are 64 ms of input, as a client would send them.
+    // tone_error_db: a 1 kHz tone's distortion + noise after conversion (lower is better).
+    // alias_db: a 10 kHz tone (above the 8 kHz output Nyquist) leaking through, relative to its input level.
+    static void BM_Resample(benchmark::State& state) {
+        int rate = static_cast<int>(state.range(0));
+        size_t frame = static_cast<size_t>(rate) * 64 / 1000;
+
+        state.counters["tone_error_db"] = ResidualDb(ResampleAll(rate, Tone(rate, 1000.0, rate)), 1000.0, VAD_SAMPLE_RATE, 1000);
+        auto alias = ResampleAll(rate, Tone(rate, 10000.0, rate));
+        double leak = 0.0;
+        for (size_t i = 1000; i < alias.size(); ++i) leak += static_cast<double>(alias[i]) * alias[i];
+        leak /= static_cast<double>(alias.size() - 1000);
+        state.counters["alias_db"] = 10.0 * std::log10((leak + 1e-9) / (10000.0 * 10000.0 / 2.0));
+
+        Resampler resampler(rate, VAD_SAMPLE_RATE);
+        state.counters["taps_per_phase"] = static_cast<double>(resampler.GetTapsPerPhase());
+        auto x = TestAudio(frame);
+        std::vector<int16_t> out;
+        out.reserve(resampler.MaxOutput(frame));
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            out.clear();
+            resampler.Process(x.data(), frame, out);
+            benchmark::DoNotOptimize(out.data());
+        }
+        state.SetItemsProcessed(state.iterations() * frame);
+        // Seconds of input converted per CPU second, i.e. realtime streams one core can take
+        state.counters["streams_per_core"] = benchmark::Counter(0.064 * state.iterations(), benchmark::Counter::kIsRate);
+    }
+    BENCHMARK(BM_Resample)->Arg(48000)->Arg(44100);
+
+    // --- SimpleAGC::Process on one VAD chunk (the sidechain does this per 512 samples) ---
+
+    static void BM_AGCProcess(benchmark::State& state) {
+        auto source = TestAudio(VAD_CHUNK_SIZE);
+        std::vector<int16_t> chunk(VAD_CHUNK_SIZE);
+        SimpleAGC agc;
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            std::memcpy(chunk.data(), source.data(), VAD_CHUNK_SIZE * sizeof(int16_t));
+            agc.Process(chunk);
+            benchmark::DoNotOptimize(chunk.data());
+        }
+        state.SetItemsProcessed(state.iterations() * VAD_CHUNK_SIZE);
+    }
+    BENCHMARK(BM_AGCProcess);
+
+    // --- Ring buffers: one frame in, one frame out ---
+
+    static void BM_RingBufferFrame(benchmark::State& state) {
+        size_t frame = static_cast<size_t>(state.range(0));
+        auto x = TestAudio(frame);
+        std::vector<int16_t> out(frame);
+        RingBuffer<int16_t> ring(frame * 4, DropPolicy::DROP_OLDEST);
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            ring.Write(x.data(), frame);
+            ring.Read(out.data(), frame);
+        }
+        state.SetBytesProcessed(state.iterations() * frame * sizeof(int16_t));
+    }
+    BENCHMARK(BM_RingBufferFrame)->Arg(512)->Arg(2048);
+
+    static void BM_SPSCRingBufferFrame(benchmark::State& state) {
+        size_t frame = static_cast<size_t>(state.range(0));
+        auto x = TestAudio(frame);
+        std::vector<int16_t> out(frame);
+        SPSCRingBuffer<int16_t> ring(frame * 4);
+        for (auto _ : state) {
+            ring.Write(x.data(), frame);
+            ring.Read(out.data(), frame);
+        }
+        state.SetBytesProcessed(state.iterations() * frame * sizeof(int16_t));
+    }
+    BENCHMARK(BM_SPSCRingBufferFrame)->Arg(512)->Arg(2048);
+}
+}
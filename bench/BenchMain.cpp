@@ -0,0 +1,58 @@
+// boww_bench: hot-path microbenchmarks.
+//
+//   ./boww_bench                                          # console table
+//   ./boww_bench --benchmark_format=json --benchmark_out=bench.json
+//
+// The JSON context records the DSP instruction set so x86 and ARM runs can be compared.
+
+#include <cstdlib>
+#include <new>
+#include <benchmark/benchmark.h>
+
+#include "BenchUtil.h"
+#include "DSPKernels.h"
+
+namespace boww {
+namespace bench {
+    std::atomic<uint64_t> g_allocations{0};
+}
+}
+
+void* operator new(std::size_t size) {
+    boww::bench::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    boww::bench::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t a = static_cast<std::size_t>(align);
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+int main(int argc, char** argv) {
+    benchmark::AddCustomContext("dsp_isa", boww::dsp::ActiveISA());
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,269 @@
+// Group audio path: HandleAudioStream per frame size, per-frame dispatch with many
+// sessions, and the output producer side (AudioOutputRouter::WriteChunk to file or ALSA).
+// VAD runs through a scheduler with no model loaded, so these measure everything
+// around inference; BM_VAD* covers inference itself. BM_VADWorkers is the exception:
+// it loads the model and measures the scheduler's worker pool end to end.
+// BM_IdleWakeups and BM_TimerLateness cover the deadline timers: wakeups with nothing to
+// do, and how late a timer handler runs against its deadline.
+
+#include <filesystem>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include <websocketpp/common/asio.hpp>
+
+#include "BenchUtil.h"
+#include "GroupController.h"
+#include "AudioOutputRouter.h"
+#include "AsyncFileWriter.h"
+#include "BoWWServer.h"
+#include "BinaryProtocol.h"
+
+namespace boww {
+namespace bench {
+
+    static GroupConfig BenchConfig(OutputType output, int sample_rate = DEFAULT_SAMPLE_RATE) {
+        GroupConfig config;
+        config.name = "bench";
+        config.output_type = output;
+        config.sample_rate = sample_rate;
+        config.arbitration_timeout_ms = 0;
+        config.preroll_ms = 0;
+        return config;
+    }
+
+    // One group with one client that has already won arbitration
+    struct LockedGroup {
+        websocketpp::lib::asio::io_service io;
+        VADEngine engine;
+        VADScheduler scheduler{engine};
+        std::shared_ptr<GroupController> group;
+        std::shared_ptr<ClientSession> session;
+
+        explicit LockedGroup(int sample_rate = DEFAULT_SAMPLE_RATE) {
+            std::filesystem::create_directories("wav");
+            scheduler.Start();
+            group = std::make_shared<GroupController>(BenchConfig(OutputType::FILE, sample_rate), scheduler, io);
+            session = std::make_shared<ClientSession>(websocketpp::connection_hdl(), nullptr);
+            session->SetGUID("bench-client", "bench");
+            group->HandleConfidenceScore(session, 1.0f);
+            // The only member has scored, so this locks at once; the loop is for a timeout fallback
+            while (group->GetState() != GroupState::LOCKED && io.run_one() > 0) {}
+        }
+
+        ~LockedGroup() { scheduler.Stop(); }
+    };
+
+    // Native-rate groups add the sidechain resampler; frames are 64 ms at 16k, 48k and 44.1k
+    static void BM_HandleAudioStream(benchmark::State& state, int sample_rate) {
+        size_t frame = static_cast<size_t>(state.range(0));
+        auto pcm = TestAudio(frame);
+        LockedGroup g(sample_rate);
+        if (g.group->GetState() != GroupState::LOCKED) { state.SkipWithError("group did not lock"); return; }
+
+        // Warm-up: the first frames size the jitter buffer and scratch vectors; after that
+        // the locked path must not touch the heap
+        for (int i = 0; i < 16; ++i) g.group->HandleAudioStream(g.session, PcmView(pcm));
+        AllocCounter allocs(state, true);
+        for (auto _ : state) {
+            g.group->HandleAudioStream(g.session, PcmView(pcm));
+        }
+        state.SetItemsProcessed(state.iterations() * frame);
+    }
+    BENCHMARK_CAPTURE(BM_HandleAudioStream, 16k, 16000)->Arg(160)->Arg(512)->Arg(1024)->Arg(4096);
+    BENCHMARK_CAPTURE(BM_HandleAudioStream, 48k, 48000)->Arg(3072);
+    BENCHMARK_CAPTURE(BM_HandleAudioStream, 44k1, 44100)->Arg(2822);
+
+    // OnMessage's binary path for an authenticated session: BoWWServer::ParseBinary ->
+    // cached group -> BoWWServer::DispatchAudio (the production strand handler) -> run,
+    // round-robin over range(0) sessions; range(1) = 1 for binary-framed clients (header
+    // decode, sequence/jitter tracking). The group is idle, so this is the per-frame cost
+    // before any DSP. Each session reuses one message: websocketpp's own per-message
+    // allocation (message object and payload from its connection manager) is not covered.
+    static void BM_FrameDispatch(benchmark::State& state) {
+        using Message = ServerType::message_ptr::element_type;
+        size_t count = static_cast<size_t>(state.range(0));
+        bool framed = state.range(1) != 0;
+        websocketpp::lib::asio::io_service io;
+        VADEngine engine;
+        VADScheduler scheduler(engine);
+        auto group = std::make_shared<GroupController>(BenchConfig(OutputType::FILE), scheduler, io);
+
+        auto pcm = TestAudio(1024);
+        std::string audio(reinterpret_cast<const char*>(pcm.data()), pcm.size() * sizeof(int16_t));
+        std::vector<std::shared_ptr<ClientSession>> sessions;
+        std::vector<ServerType::message_ptr> messages;
+        for (size_t i = 0; i < count; ++i) {
+            sessions.push_back(std::make_shared<ClientSession>(websocketpp::connection_hdl(), nullptr));
+            sessions.back()->SetGUID("bench-client-" + std::to_string(i), "bench");
+            sessions.back()->SetBinaryProtocol(framed);
+            sessions.back()->AttachGroup(group);
+            messages.push_back(std::make_shared<Message>(nullptr, websocketpp::frame::opcode::binary, Binary::HEADER_SIZE + audio.size()));
+            messages.back()->set_payload(framed ? std::string(Binary::HEADER_SIZE, '\0') + audio : audio);
+        }
+
+        std::vector<uint32_t> seq(count, 0);
+        auto dispatch = [&](size_t i) {
+            if (framed) {
+                Binary::Header header;
+                header.seq = seq[i]++;     // In order per session, so nothing counts as lost
+                header.timestamp_us = Binary::NowMicros();
+                Binary::Encode(header, reinterpret_cast<uint8_t*>(&messages[i]->get_raw_payload()[0]));
+            }
+            BoWWServer::AudioFrame frame;
+            float score = 0.0f;
+            if (BoWWServer::ParseBinary(*sessions[i], messages[i]->get_payload(), frame, score) == BoWWServer::FrameKind::AUDIO) {
+                if (auto g = sessions[i]->GetGroupController()) BoWWServer::DispatchAudio(g, sessions[i], messages[i], frame);
+            }
+            io.poll_one();
+        };
+        // Warm-up: one frame per session, so asio's handler memory is already recycled
+        for (size_t i = 0; i < count; ++i) dispatch(i);
+
+        size_t next = 0;
+        AllocCounter allocs(state, true);
+        for (auto _ : state) {
+            dispatch(next);
+            next = (next + 1 == count) ? 0 : next + 1;
+        }
+    }
+    BENCHMARK(BM_FrameDispatch)->Args({1, 0})->Args({1000, 0})->Args({1000, 1});
+
+    // range(0) workers, range(1) locked groups; each iteration submits one chunk per group
+    // and waits for every result, so items_per_second is end-to-end VAD chunks/s
+    static void BM_VADWorkers(benchmark::State& state) {
+        const int workers = static_cast<int>(state.range(0));
+        const size_t groups = static_cast<size_t>(state.range(1));
+        websocketpp::lib::asio::io_service io;
+        VADEngine engine;
+        if (!engine.Initialize(ModelPath())) { state.SkipWithError("VAD model not found (set BOWW_VAD_MODEL)"); return; }
+        VADScheduler scheduler(engine, 8, 2000, workers, 8);
+        scheduler.Start();
+
+        std::filesystem::create_directories("wav");
+        std::vector<std::shared_ptr<GroupController>> group;
+        std::vector<std::shared_ptr<ClientSession>> session;
+        for (size_t i = 0; i < groups; ++i) {
+            GroupConfig config = BenchConfig(OutputType::FILE);
+            config.name = "bench-" + std::to_string(i);
+            group.push_back(std::make_shared<GroupController>(config, scheduler, io));
+            session.push_back(std::make_shared<ClientSession>(websocketpp::connection_hdl(), nullptr));
+            session.back()->SetGUID("bench-client-" + std::to_string(i), config.name);
+            group.back()->HandleConfidenceScore(session.back(), 1.0f);
+        }
+        while (io.poll_one() > 0) {}
+
+        auto pcm = TestAudio(VAD_CHUNK_SIZE);
+        auto results = [&]() {
+            uint64_t n = 0;
+            for (auto& g : group) n += g->GetMetrics().vad_latency.Count();
+            return n;
+        };
+        uint64_t expected = results();
+        for (auto _ : state) {
+            for (size_t i = 0; i < groups; ++i) group[i]->HandleAudioStream(session[i], PcmView(pcm));
+            expected += groups;
+            while (results() < expected) std::this_thread::yield();
+        }
+        scheduler.Stop();
+        state.SetItemsProcessed(state.iterations() * groups);
+    }
+    BENCHMARK(BM_VADWorkers)->Args({1, 16})->Args({2, 16})->Args({4, 16})->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+    // range(0) idle groups left alone for 100 ms per iteration. Groups only arm a timer
+    // while arbitrating or locked, so wakeups_per_s should be 0 however many there are.
+    static void BM_IdleWakeups(benchmark::State& state) {
+        const size_t count = static_cast<size_t>(state.range(0));
+        websocketpp::lib::asio::io_service io;
+        websocketpp::lib::asio::io_service::work keep_running(io);
+        VADEngine engine;
+        VADScheduler scheduler(engine);
+        std::vector<std::shared_ptr<GroupController>> groups;
+        for (size_t i = 0; i < count; ++i) {
+            GroupConfig config = BenchConfig(OutputType::FILE);
+            config.name = "bench-" + std::to_string(i);
+            groups.push_back(std::make_shared<GroupController>(config, scheduler, io));
+        }
+        auto fired = [&]() {
+            uint64_t n = 0;
+            for (auto& g : groups) n += g->GetMetrics().timer_wakeups.load();
+            return n;
+        };
+
+        uint64_t fired_before = fired();
+        uint64_t handlers = 0;
+        for (auto _ : state) {
+            io.restart();
+            handlers += io.run_for(std::chrono::milliseconds(100));
+        }
+        state.counters["wakeups_per_s"] = benchmark::Counter(static_cast<double>(handlers), benchmark::Counter::kIsRate);
+        state.counters["timer_wakeups"] = static_cast<double>(fired() - fired_before);
+    }
+    BENCHMARK(BM_IdleWakeups)->Arg(1)->Arg(100)->Iterations(5)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+    // One arbitration round per iteration that has to wait for its timer: a second member
+    // never scores, so the round resolves on arbitration_timeout_ms and then ends on
+    // vad_no_voice_ms with no audio. lateness_us is the mean deadline-to-handler delay.
+    static void BM_TimerLateness(benchmark::State& state) {
+        websocketpp::lib::asio::io_service io;
+        VADEngine engine;
+        VADScheduler scheduler(engine);
+        std::filesystem::create_directories("wav");
+        GroupConfig config = BenchConfig(OutputType::FILE);
+        config.arbitration_timeout_ms = 5;
+        config.vad_no_voice_ms = 5;
+        auto group = std::make_shared<GroupController>(config, scheduler, io);
+        auto session = std::make_shared<ClientSession>(websocketpp::connection_hdl(), nullptr);
+        auto silent = std::make_shared<ClientSession>(websocketpp::connection_hdl(), nullptr);
+        session->SetGUID("bench-client", "bench");
+        silent->SetGUID("bench-silent", "bench");
+        group->AddMember(session);
+        group->AddMember(silent);
+
+        const Histogram& lateness = group->GetMetrics().timer_lateness;
+        uint64_t count_before = lateness.Count();
+        uint64_t sum_before = lateness.SumMicros();
+        for (auto _ : state) {
+            group->HandleConfidenceScore(session, 1.0f);
+            while (group->GetState() != GroupState::IDLE && io.run_one() > 0) {}
+            io.restart();
+        }
+        uint64_t fired = lateness.Count() - count_before;
+        state.counters["timer_wakeups"] = static_cast<double>(fired);
+        state.counters["lateness_us"] = static_cast<double>(lateness.SumMicros() - sum_before) / static_cast<double>(std::max<uint64_t>(1, fired));
+    }
+    BENCHMARK(BM_TimerLateness)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+    static void BM_WriteChunk(benchmark::State& state, OutputType output) {
+        if (output == OutputType::FLAC && !AsyncFileWriter::SupportsFlac()) {
+            state.SkipWithError("built without libFLAC");
+            return;
+        }
+        std::filesystem::create_directories("wav");
+        GroupConfig config = BenchConfig(output);
+        config.output_target = "null";             // ALSA null plugin: no sound hardware needed
+        config.fallback_to_file_on_busy = false;
+        AudioOutputRouter router(config);
+        router.OpenStream("bench-client");
+        auto chunk = TestAudio(2048);
+        auto dropped = [&]() {
+            return output == OutputType::ALSA ? router.GetPlaybackStats().dropped_samples.load()
+                                              : router.GetWriterStats().dropped_samples.load();
+        };
+
+        uint64_t dropped_before = dropped();
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            router.WriteChunk(chunk);
+        }
+        state.SetBytesProcessed(state.iterations() * chunk.size() * sizeof(int16_t));
+        // Non-zero means the writer thread (disk or encoder) could not keep up with this rate.
+        // For ALSA it always is: the device consumes in real time, so this is producer cost only.
+        // The same holds for flac: the encoder runs on the writer thread, see BM_EncodeFlac.
+        state.counters["dropped_samples"] = static_cast<double>(dropped() - dropped_before);
+        router.CloseStream();
+    }
+    BENCHMARK_CAPTURE(BM_WriteChunk, wav, OutputType::FILE);
+    BENCHMARK_CAPTURE(BM_WriteChunk, flac, OutputType::FLAC);
+    BENCHMARK_CAPTURE(BM_WriteChunk, alsa_null, OutputType::ALSA);
+}
+}
@@ -0,0 +1,75 @@
+// Control messages as handled by BoWWServer: JSON text packets and the binary framing
+
+#include <cstring>
+#include <string>
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include "BenchUtil.h"
+#include "BoWWServerDefs.h"
+#include "BinaryProtocol.h"
+
+namespace boww {
+namespace bench {
+
+    static void BM_ParseHello(benchmark::State& state) {
+        const std::string payload = R"({"type": "hello", "guid": "3f2b8c1e-9a4d-4e7b-b0c5-6d1e2f3a4b5c"})";
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            auto j = nlohmann::json::parse(payload);
+            std::string type = j["type"];
+            if (type == Protocol::MSG_HELLO) {
+                std::string guid = j["guid"];
+                benchmark::DoNotOptimize(guid.data());
+            }
+        }
+    }
+    BENCHMARK(BM_ParseHello);
+
+    // Parse + the conf_rec reply serialization that follows every confidence message
+    static void BM_ParseConfidence(benchmark::State& state) {
+        const std::string payload = R"({"type": "confidence", "value": 0.87})";
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            auto j = nlohmann::json::parse(payload);
+            std::string type = j["type"];
+            if (type == Protocol::MSG_CONFIDENCE) {
+                float score = j["value"];
+                benchmark::DoNotOptimize(score);
+                std::string reply = nlohmann::json{{"type", Protocol::MSG_CONF_REC}}.dump();
+                benchmark::DoNotOptimize(reply.data());
+            }
+        }
+    }
+    BENCHMARK(BM_ParseConfidence);
+
+    // Same round trip with the binary framing: decode header + score, encode the conf_rec header
+    static void BM_ParseConfidenceBinary(benchmark::State& state) {
+        uint8_t frame[Binary::HEADER_SIZE + sizeof(float)];
+        Binary::Header in;
+        in.type = Binary::Type::CONFIDENCE;
+        in.seq = 7;
+        in.timestamp_us = Binary::NowMicros();
+        Binary::Encode(in, frame);
+        const float value = 0.87f;
+        std::memcpy(frame + Binary::HEADER_SIZE, &value, sizeof(float));
+
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            Binary::Header header;
+            if (Binary::Decode(frame, sizeof(frame), header) && header.type == Binary::Type::CONFIDENCE) {
+                float score;
+                std::memcpy(&score, frame + Binary::HEADER_SIZE, sizeof(float));
+                benchmark::DoNotOptimize(score);
+                Binary::Header reply;
+                reply.type = Binary::Type::CONF_REC;
+                reply.seq = header.seq;
+                uint8_t out[Binary::HEADER_SIZE];
+                Binary::Encode(reply, out);
+                benchmark::DoNotOptimize(out);
+            }
+        }
+    }
+    BENCHMARK(BM_ParseConfidenceBinary);
+}
+}
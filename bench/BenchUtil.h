@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+namespace boww {
+namespace bench {
+
+    // Heap allocations made by this process (counted by the operator new in BenchMain.cpp)
+    extern std::atomic<uint64_t> g_allocations;
+
+    // Reports heap allocations per iteration for whatever ran since construction. With
+    // require_none the case fails instead when anything allocated: construct it after a
+    // warm-up so only the steady state is counted.
+    class AllocCounter {
+    public:
+        explicit AllocCounter(benchmark::State& state, bool require_none = false)
+            : state_(state), require_none_(require_none), start_(g_allocations.load()) {}
+        ~AllocCounter() {
+            uint64_t allocs = g_allocations.load() - start_;
+            state_.counters["allocs_per_iter"] = benchmark::Counter(static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+            if (require_none_ && allocs > 0) {
+                state_.SkipWithError(("steady state allocated " + std::to_string(allocs) + " times").c_str());
+            }
+        }
+    private:
+        benchmark::State& state_;
+        bool require_none_;
+        uint64_t start_;
+    };
+
+    // Deterministic speech-like test signal: a few harmonics plus noise, mid level
+    inline std::vector<int16_t> TestAudio(size_t samples, unsigned seed = 1) {
+        std::vector<int16_t> out(samples);
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> noise(0.0f, 300.0f);
+        for (size_t i = 0; i < samples; ++i) {
+            float t = static_cast<float>(i) / 16000.0f;
+            float v = 4000.0f * std::sin(2.0f * 3.14159265f * 180.0f * t)
+                    + 2000.0f * std::sin(2.0f * 3.14159265f * 720.0f * t)
+                    + noise(rng);
+            out[i] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, v)));
+        }
+        return out;
+    }
+
+    // Silero model for the VAD benchmarks (override with BOWW_VAD_MODEL)
+    inline std::string ModelPath() {
+        const char* env = std::getenv("BOWW_VAD_MODEL");
+        return env ? env : "../models/silero_vad.onnx";
+    }
+}
+}
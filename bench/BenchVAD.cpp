@@ -0,0 +1,109 @@
+// Silero inference: single-stream Process() and stacked ProcessBatch() at several widths.
+// Needs the model (see ModelPath()); skipped with an error otherwise.
+//
+// The server runs VAD through VADScheduler, i.e. ProcessBatch (BM_VADBatch, width 1 when
+// one room is talking); Process() is the single-stream API used by --replay. BM_VADProcess
+// must not touch the heap once warm; BM_VADProcessCopyBack is the Process() it replaced
+// (tensors and outputs allocated per call, stateN copied back), kept as the before figure.
+
+#include <cstring>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <onnxruntime_cxx_api.h>
+
+#include "BenchUtil.h"
+#include "DSPKernels.h"
+#include "VADEngine.h"
+
+namespace boww {
+namespace bench {
+
+    static VADEngine* Engine() {
+        static VADEngine engine;
+        static bool ready = engine.Initialize(ModelPath());
+        return ready ? &engine : nullptr;
+    }
+
+    static void BM_VADProcess(benchmark::State& state) {
+        VADEngine* engine = Engine();
+        if (!engine) { state.SkipWithError("VAD model not found (set BOWW_VAD_MODEL)"); return; }
+
+        auto chunk = TestAudio(VAD_CHUNK_SIZE);
+        auto session = engine->CreateSessionState();
+        // Warm-up: ONNX Runtime sizes its arena on the first runs of each binding parity
+        for (int i = 0; i < 4; ++i) engine->Process(session, PcmView(chunk));
+        AllocCounter allocs(state, true);
+        for (auto _ : state) {
+            float p = engine->Process(session, PcmView(chunk));
+            benchmark::DoNotOptimize(p);
+        }
+        state.SetItemsProcessed(state.iterations());     // Chunks
+    }
+    BENCHMARK(BM_VADProcess)->Unit(benchmark::kMicrosecond);
+
+    // Before: the original per-call Process(), on its own session with the engine's options
+    static void BM_VADProcessCopyBack(benchmark::State& state) {
+        Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "BoWW_VAD_bench");
+        Ort::SessionOptions options;
+        options.SetIntraOpNumThreads(1);
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        std::unique_ptr<Ort::Session> session;
+        try {
+            session = std::make_unique<Ort::Session>(env, ModelPath().c_str(), options);
+        } catch (const Ort::Exception&) {
+            state.SkipWithError("VAD model not found (set BOWW_VAD_MODEL)");
+            return;
+        }
+        auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        auto pcm = TestAudio(VAD_CHUNK_SIZE);
+        std::vector<float> vad_state(VAD_STATE_SIZE, 0.0f);
+        std::vector<int64_t> sr{VAD_SAMPLE_RATE};
+        const char* input_names[] = {"input", "state", "sr"};
+        const char* output_names[] = {"output", "stateN"};
+
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            std::vector<float> input(pcm.size());
+            for (size_t i = 0; i < pcm.size(); ++i) input[i] = static_cast<float>(pcm[i]) / 32768.0f;
+            std::vector<int64_t> input_shape = {1, static_cast<int64_t>(input.size())};
+            std::vector<int64_t> state_shape = {2, 1, static_cast<int64_t>(VAD_STATE_DIM)};
+            std::vector<int64_t> sr_shape = {1};
+            std::vector<Ort::Value> inputs;
+            inputs.push_back(Ort::Value::CreateTensor<float>(memory_info, input.data(), input.size(), input_shape.data(), input_shape.size()));
+            inputs.push_back(Ort::Value::CreateTensor<float>(memory_info, vad_state.data(), vad_state.size(), state_shape.data(), state_shape.size()));
+            inputs.push_back(Ort::Value::CreateTensor<int64_t>(memory_info, sr.data(), sr.size(), sr_shape.data(), sr_shape.size()));
+            auto outputs = session->Run(Ort::RunOptions{nullptr}, input_names, inputs.data(), 3, output_names, 2);
+            std::memcpy(vad_state.data(), outputs[1].GetTensorMutableData<float>(), vad_state.size() * sizeof(float));
+            benchmark::DoNotOptimize(outputs[0].GetTensorMutableData<float>()[0]);
+        }
+        state.SetItemsProcessed(state.iterations());     // Chunks
+    }
+    BENCHMARK(BM_VADProcessCopyBack)->Unit(benchmark::kMicrosecond);
+
+    static void BM_VADBatch(benchmark::State& state) {
+        VADEngine* engine = Engine();
+        if (!engine) { state.SkipWithError("VAD model not found (set BOWW_VAD_MODEL)"); return; }
+
+        size_t width = static_cast<size_t>(state.range(0));
+        auto pcm = TestAudio(VAD_CHUNK_SIZE);
+        std::vector<float> chunk(VAD_CHUNK_SIZE);
+        dsp::Int16ToFloat(pcm.data(), chunk.data(), VAD_CHUNK_SIZE);
+
+        std::vector<std::shared_ptr<VADSessionState>> sessions;
+        for (size_t i = 0; i < width; ++i) sessions.push_back(engine->CreateSessionState());
+        VADBatch batch;
+        batch.Reserve(width);
+
+        AllocCounter allocs(state);
+        for (auto _ : state) {
+            batch.Clear();
+            for (auto& s : sessions) batch.Add(s.get(), chunk.data());
+            bool ok = engine->ProcessBatch(batch);
+            benchmark::DoNotOptimize(ok);
+        }
+        // items_per_second is chunks/s across the batch; its inverse is the per-chunk cost
+        state.SetItemsProcessed(state.iterations() * width);
+    }
+    BENCHMARK(BM_VADBatch)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMicrosecond);
+}
+}
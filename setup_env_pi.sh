@@ -11,6 +11,9 @@ sudo apt-get install -y \
     libasound2-dev \
     libboost-all-dev \
     libwebsocketpp-dev \
+    libflac-dev \
+    libopus-dev \
+    libbenchmark-dev \
     wget \
     tar
 
@@ -0,0 +1,359 @@
+#include "AlsaPlayback.h"
+#include "DSPKernels.h"
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <map>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#ifdef __LINUX_ALSA__
+    #include <alsa/asoundlib.h>
+#endif
+
+namespace boww {
+
+    static constexpr int kRealtimePriority = 60;     // Below the kernel's IRQ threads (50-99 are common)
+    static constexpr size_t kForwardBlock = 4096;    // Fallback copy granularity (samples)
+
+    bool AlsaPlayback::IsAvailable() {
+#ifdef __LINUX_ALSA__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    AlsaPlayback::Source::Source(std::shared_ptr<PlaybackStats> stats, int sample_rate, int channels, float gain,
+                                 std::string fallback_path, size_t queue_samples)
+        : ring_(queue_samples), stats_(std::move(stats)), sample_rate_(sample_rate), channels_(std::max(1, channels)),
+          fallback_path_(std::move(fallback_path)), gain_(gain) {}
+
+    void AlsaPlayback::Source::Write(const int16_t* data, size_t count) {
+        // Whole frames only, so a full ring never leaves the channels out of step
+        size_t fits = std::min(count, ring_.Free());
+        fits -= fits % channels_;
+        size_t written = ring_.Write(data, fits);
+        if (written < count) {
+            stats_->dropped_samples += count - written;
+        }
+        stats_->queued_samples = ring_.Size();
+    }
+
+    std::shared_ptr<AlsaPlayback> AlsaPlayback::ForDevice(const std::string& device) {
+        static std::mutex registry_mutex;
+        static std::map<std::string, std::weak_ptr<AlsaPlayback>> registry;
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::weak_ptr<AlsaPlayback>& slot = registry[device];
+        std::shared_ptr<AlsaPlayback> playback = slot.lock();
+        if (!playback) {
+            playback = std::make_shared<AlsaPlayback>(device);
+            slot = playback;
+        }
+        return playback;
+    }
+
+    void AlsaPlayback::Release(std::shared_ptr<AlsaPlayback> playback) {
+        if (!playback) return;
+        // The registry only holds weak references, so while the reaper owns the engine a
+        // new router for the same device still gets it back from ForDevice
+        std::thread([playback = std::move(playback)]() mutable { playback.reset(); }).detach();
+    }
+
+    AlsaPlayback::AlsaPlayback(std::string device, size_t queue_samples)
+        : device_(std::move(device)), queue_samples_(queue_samples)
+    {
+        scratch_.resize(kForwardBlock);
+        thread_ = std::thread(&AlsaPlayback::MixerLoop, this);
+    }
+
+    AlsaPlayback::~AlsaPlayback() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    std::shared_ptr<AlsaPlayback::Source> AlsaPlayback::Open(std::shared_ptr<PlaybackStats> stats, int sample_rate, int channels,
+                                                             float gain, const std::string& fallback_path) {
+        auto source = std::make_shared<Source>(std::move(stats), sample_rate, channels, gain, fallback_path, queue_samples_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            added_.push_back(source);
+        }
+        cv_.notify_one();
+        return source;
+    }
+
+    void AlsaPlayback::MixerLoop() {
+#ifdef __linux__
+        sched_param param{};
+        param.sched_priority = kRealtimePriority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+            std::cout << "[Playback] SCHED_FIFO not permitted; mixer for " << device_ << " runs at normal priority." << std::endl;
+        }
+#endif
+        std::vector<std::shared_ptr<Source>> added;
+
+        while (true) {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                // An open device paces the loop (snd_pcm_wait in Play); otherwise only new
+                // sources and fallback data need attention
+                if (!pcm_) cv_.wait_for(lock, std::chrono::milliseconds(50), [this]() { return stop_ || !added_.empty(); });
+                added.swap(added_);
+                stop = stop_;
+            }
+
+            for (auto& source : added) Attach(source);
+            added.clear();
+            // Last user is gone: play out what is queued, then exit
+            if (stop) for (auto& source : sources_) source->Close();
+
+            if (pcm_) Play();
+            for (auto& source : sources_) {
+                if (!source->mixing_) Forward(*source);
+            }
+            Reap();
+
+            if (stop && sources_.empty()) break;
+        }
+        CloseDevice();
+    }
+
+    void AlsaPlayback::Attach(const std::shared_ptr<Source>& source) {
+        if (!pcm_ && !OpenDevice(source->sample_rate_, source->channels_)) {
+            source->stats_->open_failures++;
+        }
+        sources_.push_back(source);
+
+        if (pcm_ && source->sample_rate_ == rate_ && source->channels_ == channels_) {
+            source->mixing_ = true;
+            source->prefilling_ = true;
+            return;
+        }
+        if (pcm_) {
+            std::cerr << "[Playback] " << device_ << " is open at " << rate_ << " Hz x" << channels_ << "; a "
+                      << source->sample_rate_ << " Hz x" << source->channels_ << " stream cannot join the mix." << std::endl;
+        }
+        StartFallback(*source);
+    }
+
+    void AlsaPlayback::StartFallback(Source& source) {
+        if (source.fallback_path_.empty() || source.fallback_) return;
+        // Writers are reused: destroying one joins its thread, which the mixer must not wait on
+        if (!spare_writers_.empty()) {
+            source.fallback_ = std::move(spare_writers_.back());
+            spare_writers_.pop_back();
+        } else {
+            source.fallback_ = std::make_unique<AsyncFileWriter>();
+        }
+        source.fallback_->Open(source.fallback_path_, source.sample_rate_, source.channels_);
+        std::cout << "[Playback] Fallback to FILE: " << source.fallback_path_ << std::endl;
+    }
+
+    bool AlsaPlayback::OpenDevice(int sample_rate, int channels) {
+        rate_ = sample_rate;
+        channels_ = channels;
+        period_frames_ = static_cast<size_t>(std::max(1, sample_rate * kPeriodMs / 1000));
+        std::string error = "ALSA not compiled";
+
+#ifdef __LINUX_ALSA__
+        snd_pcm_t* pcm = nullptr;
+        int err = snd_pcm_open(&pcm, device_.c_str(), SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
+        if (err >= 0) {
+            snd_pcm_hw_params_t* hw;
+            snd_pcm_hw_params_alloca(&hw);
+            snd_pcm_uframes_t period = period_frames_;
+            snd_pcm_uframes_t buffer = period_frames_ * kPeriods;
+            if ((err = snd_pcm_hw_params_any(pcm, hw)) >= 0 &&
+                (err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) >= 0 &&
+                (err = snd_pcm_hw_params_set_format(pcm, hw, SND_PCM_FORMAT_S16_LE)) >= 0 &&
+                (err = snd_pcm_hw_params_set_channels(pcm, hw, static_cast<unsigned>(channels))) >= 0 &&
+                (err = snd_pcm_hw_params_set_rate(pcm, hw, static_cast<unsigned>(sample_rate), 0)) >= 0 &&
+                (err = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, nullptr)) >= 0 &&
+                (err = snd_pcm_hw_params_set_buffer_size_near(pcm, hw, &buffer)) >= 0 &&
+                (err = snd_pcm_hw_params(pcm, hw)) >= 0) {
+                period_frames_ = period;
+
+                // Start once two periods are in; wake whenever a period is free
+                snd_pcm_sw_params_t* sw;
+                snd_pcm_sw_params_alloca(&sw);
+                if ((err = snd_pcm_sw_params_current(pcm, sw)) >= 0 &&
+                    (err = snd_pcm_sw_params_set_start_threshold(pcm, sw, std::min(buffer, 2 * period))) >= 0 &&
+                    (err = snd_pcm_sw_params_set_avail_min(pcm, sw, period)) >= 0) {
+                    err = snd_pcm_sw_params(pcm, sw);
+                }
+            }
+            if (err < 0) snd_pcm_close(pcm);
+            else pcm_ = pcm;
+        }
+        if (err < 0) error = snd_strerror(err);
+#endif
+
+        if (!pcm_) {
+            std::cerr << "[Playback] ALSA Error on " << device_ << ": " << error << std::endl;
+            return false;
+        }
+        size_t period_samples = period_frames_ * channels_;
+        mix_.assign(period_samples, 0.0f);
+        period_.assign(period_samples, 0);
+        scratch_.resize(std::max(period_samples, kForwardBlock));
+        std::cout << "[Playback] Opened " << device_ << " at " << rate_ << " Hz x" << channels_
+                  << " (" << period_frames_ << "-frame periods)." << std::endl;
+        return true;
+    }
+
+    void AlsaPlayback::CloseDevice() {
+#ifdef __LINUX_ALSA__
+        if (!pcm_) return;
+        // The last periods are already queued; let the device play them out
+        auto* pcm = static_cast<snd_pcm_t*>(pcm_);
+        snd_pcm_nonblock(pcm, 0);
+        snd_pcm_drain(pcm);
+        snd_pcm_close(pcm);
+#endif
+        pcm_ = nullptr;
+    }
+
+    void AlsaPlayback::Play() {
+#ifdef __LINUX_ALSA__
+        auto* pcm = static_cast<snd_pcm_t*>(pcm_);
+        int err = snd_pcm_wait(pcm, kPeriodMs * 2);
+        if (err < 0) { Recover(err); return; }
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+        if (avail < 0) { Recover(static_cast<int>(avail)); return; }
+
+        while (static_cast<size_t>(avail) >= period_frames_) {
+            MixPeriod();
+            if (!WritePeriod()) return;
+            avail -= static_cast<snd_pcm_sframes_t>(period_frames_);
+        }
+#endif
+    }
+
+    void AlsaPlayback::MixPeriod() {
+        const size_t n = period_frames_ * channels_;
+        const size_t prefill = kPrefillPeriods * n;
+        std::fill(mix_.begin(), mix_.end(), 0.0f);
+
+        for (auto& ptr : sources_) {
+            Source& source = *ptr;
+            if (!source.mixing_) continue;
+
+            // closed_ first: once it reads true, everything written before Close() is visible
+            bool closed = source.closed_.load(std::memory_order_acquire);
+            if (source.prefilling_) {
+                if (source.ring_.Size() < prefill && !closed) continue;
+                source.prefilling_ = false;
+            }
+
+            size_t got = source.ring_.Read(scratch_.data(), n);
+            if (got < n && !closed) {
+                // Ran dry mid-stream: the gap plays as silence, then rebuild the cushion
+                source.stats_->xruns++;
+                source.prefilling_ = true;
+            }
+            dsp::MixAccumulate(scratch_.data(), mix_.data(), got, source.gain_.load(std::memory_order_relaxed));
+            source.stats_->frames_played += got / channels_;
+            source.stats_->queued_samples = source.ring_.Size();
+        }
+
+        dsp::SaturateToInt16(mix_.data(), period_.data(), n);
+    }
+
+    bool AlsaPlayback::WritePeriod() {
+#ifdef __LINUX_ALSA__
+        auto* pcm = static_cast<snd_pcm_t*>(pcm_);
+        size_t done = 0;
+        while (done < period_frames_) {
+            snd_pcm_sframes_t n = snd_pcm_writei(pcm, period_.data() + done * channels_, period_frames_ - done);
+            if (n == -EAGAIN) {
+                snd_pcm_wait(pcm, kPeriodMs * 2);
+                continue;
+            }
+            if (n < 0) {
+                Recover(static_cast<int>(n));
+                return false;   // The rest of this period is lost; the next one restarts the device
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void AlsaPlayback::Recover(int err) {
+#ifdef __LINUX_ALSA__
+        if (err == -EPIPE || err == -ESTRPIPE) {
+            for (auto& source : sources_) {
+                if (source->mixing_) source->stats_->xruns++;
+            }
+        }
+        if (snd_pcm_recover(static_cast<snd_pcm_t*>(pcm_), err, 1) < 0) {
+            std::cerr << "[Playback] ALSA Error on " << device_ << ": " << snd_strerror(err) << std::endl;
+            FailDevice();
+        }
+#else
+        (void)err;
+#endif
+    }
+
+    // The device is gone for good (e.g. a USB speaker unplugged: ENODEV). Waiting on it would
+    // fail at once and spin this SCHED_FIFO thread, so close it without draining and move every
+    // mixing stream to its fallback file; the next stream to arrive tries the device again.
+    void AlsaPlayback::FailDevice() {
+#ifdef __LINUX_ALSA__
+        if (!pcm_) return;
+        auto* pcm = static_cast<snd_pcm_t*>(pcm_);
+        snd_pcm_drop(pcm);
+        snd_pcm_close(pcm);
+#endif
+        pcm_ = nullptr;
+        for (auto& source : sources_) {
+            if (!source->mixing_) continue;
+            source->mixing_ = false;
+            source->stats_->open_failures++;
+            StartFallback(*source);
+        }
+    }
+
+    void AlsaPlayback::Forward(Source& source) {
+        if (!source.fallback_) {
+            source.ring_.Discard(source.ring_.Size());
+            return;
+        }
+        size_t block = scratch_.size() - scratch_.size() % source.channels_;
+        while (size_t n = source.ring_.Read(scratch_.data(), block)) {
+            source.fallback_->Write(scratch_.data(), n);
+        }
+        source.stats_->queued_samples = 0;
+    }
+
+    bool AlsaPlayback::Finished(const Source& source) const {
+        return source.closed_.load(std::memory_order_acquire) && source.ring_.Size() == 0;
+    }
+
+    void AlsaPlayback::Reap() {
+        for (auto it = sources_.begin(); it != sources_.end();) {
+            Source& source = **it;
+            if (!Finished(source)) { ++it; continue; }
+            if (source.fallback_) {
+                source.fallback_->Close();
+                spare_writers_.push_back(std::move(source.fallback_));
+            }
+            it = sources_.erase(it);
+        }
+
+        bool mixing = std::any_of(sources_.begin(), sources_.end(), [](const auto& s) { return s->mixing_; });
+        if (pcm_ && !mixing) CloseDevice();
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RingBuffer.h"
+#include "AsyncFileWriter.h"
+
+namespace boww {
+
+    // Playback metrics for one group, readable from any thread
+    struct PlaybackStats {
+        std::atomic<uint64_t> queued_samples{0};      // Waiting in the source ring
+        std::atomic<uint64_t> dropped_samples{0};     // Lost because the ring was full
+        std::atomic<uint64_t> frames_played{0};
+        std::atomic<uint64_t> xruns{0};               // Source ran dry mid-stream, or the device underran
+        std::atomic<uint64_t> open_failures{0};       // Device would not open, or failed for good mid-stream
+    };
+
+    // One ALSA output device shared by every group that names it. Each group stream is a
+    // Source with its own lock-free SPSC ring (the group strand produces, the mixer thread
+    // consumes); one mixer thread per device (SCHED_FIFO when permitted) opens the device
+    // in non-blocking mode, and every period sums the sources that have audio, each at
+    // its own gain, with SIMD accumulation and one saturation at the end. Sources that
+    // have nothing right now contribute silence, so one room pausing never underruns
+    // another. A source joins the mix once kPrefillPeriods are queued: the group's
+    // JitterBuffer already holds back its adaptive cushion, so this only has to cover period
+    // granularity, and the stream's latency is the jitter target. The device opens with the first source (which sets its
+    // rate and channels) and is drained and closed after the last one finishes.
+    // If the device cannot be opened, or a source's format does not match the open
+    // device, that source is recorded to its fallback file instead; so are the streams
+    // in the mix if the device fails for good while playing.
+    // Works with the "null" and "file" ALSA plugins.
+    class AlsaPlayback {
+    public:
+        static constexpr int kPeriodMs = 10;
+        static constexpr int kPeriods = 4;            // Device buffer = kPeriods * kPeriodMs
+        static constexpr int kPrefillPeriods = 2;     // Also rebuilt after a source runs dry
+
+        class Source {
+        public:
+            Source(std::shared_ptr<PlaybackStats> stats, int sample_rate, int channels, float gain,
+                   std::string fallback_path, size_t queue_samples);
+
+            // Producer side (one thread): never blocks, drops what does not fit
+            void Write(const int16_t* data, size_t count);
+
+            // Plays out what is queued, then leaves the mix
+            void Close() { closed_.store(true, std::memory_order_release); }
+
+            void SetGain(float gain) { gain_.store(gain, std::memory_order_relaxed); }
+
+        private:
+            friend class AlsaPlayback;
+
+            SPSCRingBuffer<int16_t> ring_;
+            std::shared_ptr<PlaybackStats> stats_;      // Shared: the mixer may outlive the router's stream
+            const int sample_rate_;
+            const int channels_;
+            const std::string fallback_path_;
+            std::atomic<float> gain_;
+            std::atomic<bool> closed_{false};
+
+            // Mixer thread state
+            bool mixing_ = false;                       // Attached to the device (else fallback or dropped)
+            bool prefilling_ = true;
+            std::unique_ptr<AsyncFileWriter> fallback_;
+        };
+
+        // The shared engine for a device name; created on first use, stopped when the
+        // last router lets go of it
+        static std::shared_ptr<AlsaPlayback> ForDevice(const std::string& device);
+
+        // Lets go of an engine without blocking the caller: if that was the last reference,
+        // the play-out, device close and join (seconds, in the worst case) happen on a
+        // detached thread instead of the group strand
+        static void Release(std::shared_ptr<AlsaPlayback> playback);
+
+        explicit AlsaPlayback(std::string device, size_t queue_samples = 128 * 1024);
+        ~AlsaPlayback();
+
+        AlsaPlayback(const AlsaPlayback&) = delete;
+        AlsaPlayback& operator=(const AlsaPlayback&) = delete;
+
+        // Non-blocking: the device is opened (if it is not already) on the mixer thread
+        std::shared_ptr<Source> Open(std::shared_ptr<PlaybackStats> stats, int sample_rate, int channels,
+                                     float gain = 1.0f, const std::string& fallback_path = "");
+
+        const std::string& GetDevice() const { return device_; }
+
+        // False when built without ALSA (every source then takes its fallback)
+        static bool IsAvailable();
+
+    private:
+        const std::string device_;
+        const size_t queue_samples_;
+
+        // New sources are rare (one per stream), so a mutex is fine here
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::shared_ptr<Source>> added_;
+        bool stop_ = false;
+
+        std::thread thread_;
+
+        // Mixer thread state
+        std::vector<std::shared_ptr<Source>> sources_;
+        void* pcm_ = nullptr;                   // snd_pcm_t*
+        int rate_ = 0;
+        int channels_ = 0;
+        size_t period_frames_ = 0;
+        std::vector<float> mix_;                // One period, summed at float precision
+        std::vector<int16_t> period_;           // One period, saturated, as written to the device
+        std::vector<int16_t> scratch_;          // One source's period (or a fallback block)
+        std::vector<std::unique_ptr<AsyncFileWriter>> spare_writers_;   // Closed fallback writers, for reuse
+
+        void MixerLoop();
+        void Attach(const std::shared_ptr<Source>& source);
+        bool OpenDevice(int sample_rate, int channels);
+        void CloseDevice();
+        void Play();                            // Writes as many mixed periods as the device has room for
+        void MixPeriod();
+        bool WritePeriod();
+        void Recover(int err);                  // Fails the device if ALSA cannot recover it
+        void FailDevice();
+        void StartFallback(Source& source);
+        void Forward(Source& source);           // Not mixing: to the fallback file, or dropped
+        void Reap();                            // Drops finished sources; closes the device after the last
+        bool Finished(const Source& source) const;
+    };
+}
@@ -0,0 +1,364 @@
+#include "AsyncFileWriter.h"
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef BOWW_HAVE_FLAC
+    #include <FLAC/stream_encoder.h>
+#endif
+
+namespace boww {
+
+    struct WavHeader {
+        char riff[4] = {'R', 'I', 'F', 'F'};
+        uint32_t overall_size = 0;
+        char wave[4] = {'W', 'A', 'V', 'E'};
+        char fmt_chunk_marker[4] = {'f', 'm', 't', ' '};
+        uint32_t length_of_fmt = 16;
+        uint16_t format_type = 1;
+        uint16_t channels = 1;
+        uint32_t sample_rate = 16000;
+        uint32_t byterate = 0;
+        uint16_t block_align = 0;
+        uint16_t bits_per_sample = 16;
+        char data_chunk_header[4] = {'d', 'a', 't', 'a'};
+        uint32_t data_size = 0;
+    };
+
+    static constexpr size_t kDirectIOAlign = 4096;
+
+#ifdef BOWW_HAVE_FLAC
+    // libFLAC stream callbacks: encoded bytes go through the same staging/flush path as WAV
+    struct FlacCallbacks {
+        static FLAC__StreamEncoderWriteStatus Write(const FLAC__StreamEncoder*, const FLAC__byte buffer[], size_t bytes,
+                                                    uint32_t, uint32_t, void* client_data) {
+            auto* self = static_cast<AsyncFileWriter*>(client_data);
+            self->AppendBytes(buffer, bytes);
+            return self->failed_ ? FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR : FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+        }
+
+        static FLAC__StreamEncoderSeekStatus Seek(const FLAC__StreamEncoder*, FLAC__uint64 offset, void* client_data) {
+            return static_cast<AsyncFileWriter*>(client_data)->SeekTo(offset)
+                ? FLAC__STREAM_ENCODER_SEEK_STATUS_OK : FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+        }
+
+        static FLAC__StreamEncoderTellStatus Tell(const FLAC__StreamEncoder*, FLAC__uint64* offset, void* client_data) {
+            auto* self = static_cast<AsyncFileWriter*>(client_data);
+            *offset = self->file_bytes_ + self->staging_used_;
+            return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+        }
+    };
+#endif
+
+    bool AsyncFileWriter::SupportsFlac() {
+#ifdef BOWW_HAVE_FLAC
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    AsyncFileWriter::AsyncFileWriter(size_t queue_samples, bool direct_io)
+        : ring_(queue_samples), direct_io_(direct_io)
+    {
+        staging_ = static_cast<uint8_t*>(::operator new(kBlockBytes, std::align_val_t(kDirectIOAlign)));
+        thread_ = std::thread(&AsyncFileWriter::WriterLoop, this);
+    }
+
+    AsyncFileWriter::~AsyncFileWriter() {
+        PushOp(Op(OpType::STOP, ring_.TotalWritten()));
+        if (thread_.joinable()) thread_.join();
+        ::operator delete(staging_, std::align_val_t(kDirectIOAlign));
+    }
+
+    void AsyncFileWriter::Open(const std::string& path, int sample_rate, int channels, FileFormat format) {
+        Op op(OpType::OPEN, ring_.TotalWritten());
+        op.path = path;
+        op.sample_rate = sample_rate;
+        op.channels = channels;
+        op.format = format;
+        PushOp(std::move(op));
+    }
+
+    void AsyncFileWriter::Write(const int16_t* data, size_t count) {
+        size_t written = ring_.Write(data, count);
+        if (written < count) {
+            stats_.dropped_samples += count - written;
+        }
+
+        size_t depth = ring_.Size();
+        stats_.queued_samples = depth;
+        if (depth > stats_.queue_high_water) stats_.queue_high_water = depth;
+
+        // Wake the writer once a full block is waiting; otherwise it picks data up on its timer
+        if (depth * sizeof(int16_t) >= kBlockBytes) cv_.notify_one();
+    }
+
+    void AsyncFileWriter::Close() {
+        PushOp(Op(OpType::CLOSE, ring_.TotalWritten()));
+    }
+
+    void AsyncFileWriter::PushOp(Op op) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ops_.push_back(std::move(op));
+        }
+        cv_.notify_one();
+    }
+
+    void AsyncFileWriter::WriterLoop() {
+        std::vector<Op> ops;
+
+        while (true) {
+            size_t limit;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_for(lock, std::chrono::milliseconds(200), [this]() {
+                    return !ops_.empty() || ring_.Size() * sizeof(int16_t) >= kBlockBytes;
+                });
+                ops.swap(ops_);
+                // Read under the lock: anything past this belongs to ops we have not seen yet
+                limit = ring_.TotalWritten();
+            }
+
+            bool stop = false;
+            for (const Op& op : ops) {
+                Drain(op.data_end);
+                if (op.type == OpType::OPEN) OpenFile(op);
+                else if (op.type == OpType::CLOSE) CloseFile();
+                else stop = true;
+            }
+            ops.clear();
+
+            if (stop) {
+                CloseFile();
+                break;
+            }
+
+            Drain(limit);
+            stats_.queued_samples = ring_.Size();
+        }
+    }
+
+    void AsyncFileWriter::Drain(size_t data_end) {
+        while (ring_.TotalRead() < data_end) {
+            size_t want = data_end - ring_.TotalRead();
+
+            if (fd_ < 0) {
+                // Nothing open (e.g. open failed): drop the data
+                ring_.Discard(want);
+                continue;
+            }
+            if (failed_) {
+                // Anything written after a lost block would land at the wrong offset
+                stats_.dropped_samples += ring_.Discard(want);
+                continue;
+            }
+
+            if (flac_encoder_) {
+                // Whole frames only; the producer always writes whole frames
+                size_t n = std::min(want, encode_in_.size());
+                n -= n % channels_;
+                if (n == 0) { ring_.Discard(want); continue; }
+                EncodeFlac(ring_.Read(encode_in_.data(), n));
+                continue;
+            }
+
+            size_t room = (kBlockBytes - staging_used_) / sizeof(int16_t);
+            size_t n = ring_.Read(reinterpret_cast<int16_t*>(staging_ + staging_used_), std::min(want, room));
+            staging_used_ += n * sizeof(int16_t);
+            if (staging_used_ == kBlockBytes) FlushStaging(false);
+            if (n == 0) break;
+        }
+        // A partial block stays staged until it fills or the file is closed
+    }
+
+    void AsyncFileWriter::FlushStaging(bool final_block) {
+        if (fd_ < 0 || staging_used_ == 0) return;
+        if (failed_) {
+            stats_.lost_bytes += staging_used_;
+            staging_used_ = 0;
+            return;
+        }
+
+        // O_DIRECT needs aligned lengths; the tail of a file is written buffered
+        if (final_block && fd_direct_ && (staging_used_ % kDirectIOAlign) != 0) {
+            int flags = fcntl(fd_, F_GETFL);
+            fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+            fd_direct_ = false;
+        }
+
+        size_t off = 0;
+        while (off < staging_used_) {
+            ssize_t n = ::write(fd_, staging_ + off, staging_used_ - off);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "[Writer] Write Error on " << path_ << ": " << std::strerror(errno) << std::endl;
+                stats_.lost_bytes += staging_used_ - off;
+                failed_ = true;
+                break;
+            }
+            off += static_cast<size_t>(n);
+            stats_.write_calls++;
+        }
+        stats_.bytes_written += off;
+        file_bytes_ += off;
+        staging_used_ = 0;
+    }
+
+    void AsyncFileWriter::OpenFile(const Op& op) {
+        if (fd_ >= 0) CloseFile();
+
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+        fd_direct_ = false;
+        if (direct_io_) {
+            fd_ = ::open(op.path.c_str(), flags | O_DIRECT, 0644);
+            fd_direct_ = (fd_ >= 0);
+        }
+        if (fd_ < 0) {
+            // No O_DIRECT support on this filesystem (or not requested)
+            fd_ = ::open(op.path.c_str(), flags, 0644);
+        }
+        if (fd_ < 0) {
+            std::cerr << "[Writer] Cannot open " << op.path << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        file_bytes_ = 0;
+        staging_used_ = 0;
+        failed_ = false;
+        path_ = op.path;
+        channels_ = std::max(1, op.channels);
+
+        if (op.format == FileFormat::FLAC) {
+#ifdef BOWW_HAVE_FLAC
+            FLAC__StreamEncoder* enc = FLAC__stream_encoder_new();
+            if (enc) {
+                FLAC__stream_encoder_set_channels(enc, channels_);
+                FLAC__stream_encoder_set_bits_per_sample(enc, 16);
+                FLAC__stream_encoder_set_sample_rate(enc, op.sample_rate);
+                FLAC__stream_encoder_set_compression_level(enc, kFlacCompressionLevel);
+                FLAC__stream_encoder_set_verify(enc, false);
+                if (FLAC__stream_encoder_init_stream(enc, FlacCallbacks::Write, FlacCallbacks::Seek, FlacCallbacks::Tell,
+                                                     nullptr, this) == FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+                    flac_encoder_ = enc;
+                    encode_in_.resize(kEncodeFrames * channels_);
+                    encode_buf_.resize(kEncodeFrames * channels_);
+                    return;
+                }
+                FLAC__stream_encoder_delete(enc);
+            }
+#endif
+            std::cerr << "[Writer] FLAC encoder unavailable for " << op.path << ", recording raw PCM WAV." << std::endl;
+        }
+
+        // The header is the first bytes of the first block, so file offsets stay block aligned
+        WavHeader h;
+        h.sample_rate = op.sample_rate;
+        h.channels = op.channels;
+        h.block_align = op.channels * 2;
+        h.byterate = h.sample_rate * h.block_align;
+        std::memcpy(staging_, &h, sizeof(WavHeader));
+        staging_used_ = sizeof(WavHeader);
+    }
+
+    void AsyncFileWriter::CloseFile() {
+        if (fd_ < 0) return;
+
+#ifdef BOWW_HAVE_FLAC
+        if (flac_encoder_) {
+            // Emits the last frame and rewrites STREAMINFO through the seek callback
+            auto* enc = static_cast<FLAC__StreamEncoder*>(flac_encoder_);
+            FLAC__stream_encoder_finish(enc);
+            FLAC__stream_encoder_delete(enc);
+            flac_encoder_ = nullptr;
+
+            FlushStaging(true);
+            ::close(fd_);
+            fd_ = -1;
+            stats_.files_closed++;
+            if (failed_) MarkFailed();
+            else std::cout << "[Router] FLAC file closed." << std::endl;
+            return;
+        }
+#endif
+
+        FlushStaging(true);
+        if (fd_direct_) {
+            int flags = fcntl(fd_, F_GETFL);
+            fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+            fd_direct_ = false;
+        }
+
+        if (failed_ || file_bytes_ < sizeof(WavHeader)) {
+            // The sizes on disk would not describe the data, so leave the header as it is
+            failed_ = true;
+            ::close(fd_);
+            fd_ = -1;
+            stats_.files_closed++;
+            MarkFailed();
+            return;
+        }
+
+        // RIFF sizes are 32-bit: past 4 GiB the header says as much as it can
+        uint64_t data_bytes = std::min<uint64_t>(file_bytes_ - sizeof(WavHeader), UINT32_MAX - (sizeof(WavHeader) - 8));
+        data_bytes -= data_bytes % sizeof(int16_t);
+        uint32_t data_length = static_cast<uint32_t>(data_bytes);
+        uint32_t overall = static_cast<uint32_t>(data_bytes + sizeof(WavHeader) - 8);
+        if (::pwrite(fd_, &overall, 4, 4) != 4 || ::pwrite(fd_, &data_length, 4, 40) != 4) {
+            std::cerr << "[Writer] Header patch failed: " << std::strerror(errno) << std::endl;
+        }
+
+        ::close(fd_);
+        fd_ = -1;
+        stats_.files_closed++;
+        std::cout << "[Router] File closed and header patched." << std::endl;
+    }
+
+    // The file is closed; renamed so it is not taken for a complete recording
+    void AsyncFileWriter::MarkFailed() {
+        stats_.files_failed++;
+        std::string failed_path = path_ + ".failed";
+        if (::rename(path_.c_str(), failed_path.c_str()) != 0) failed_path = path_;
+        std::cerr << "[Writer] Recording incomplete after a write error: " << failed_path << std::endl;
+    }
+
+    void AsyncFileWriter::AppendBytes(const uint8_t* data, size_t bytes) {
+        while (bytes > 0) {
+            size_t n = std::min(bytes, kBlockBytes - staging_used_);
+            std::memcpy(staging_ + staging_used_, data, n);
+            staging_used_ += n;
+            data += n;
+            bytes -= n;
+            if (staging_used_ == kBlockBytes) FlushStaging(false);
+        }
+    }
+
+    bool AsyncFileWriter::SeekTo(uint64_t offset) {
+        // Only used for the final STREAMINFO rewrite: leave O_DIRECT for good
+        FlushStaging(true);
+        if (failed_) return false;
+        if (fd_direct_) {
+            int flags = fcntl(fd_, F_GETFL);
+            fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+            fd_direct_ = false;
+        }
+        if (::lseek(fd_, static_cast<off_t>(offset), SEEK_SET) < 0) return false;
+        file_bytes_ = offset;
+        return true;
+    }
+
+    void AsyncFileWriter::EncodeFlac(size_t samples) {
+#ifdef BOWW_HAVE_FLAC
+        for (size_t i = 0; i < samples; ++i) encode_buf_[i] = encode_in_[i];
+        FLAC__stream_encoder_process_interleaved(static_cast<FLAC__StreamEncoder*>(flac_encoder_),
+                                                 encode_buf_.data(), static_cast<uint32_t>(samples / channels_));
+#else
+        (void)samples;
+#endif
+    }
+}
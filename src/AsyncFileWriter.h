@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoWWServerDefs.h"
+#include "RingBuffer.h"
+
+namespace boww {
+
+    // Writer queue metrics, readable from any thread
+    struct FileWriterStats {
+        std::atomic<uint64_t> queued_samples{0};      // Currently waiting in the ring
+        std::atomic<uint64_t> queue_high_water{0};    // Peak ring depth (samples)
+        std::atomic<uint64_t> dropped_samples{0};     // Lost because the ring was full, or the file had failed
+        std::atomic<uint64_t> bytes_written{0};
+        std::atomic<uint64_t> lost_bytes{0};          // Staged for the file but not written (write error)
+        std::atomic<uint64_t> write_calls{0};
+        std::atomic<uint64_t> files_closed{0};
+        std::atomic<uint64_t> files_failed{0};        // Closed after a write error, renamed to *.failed
+    };
+
+    enum class FileFormat { WAV, FLAC };
+
+    // Moves recording off the audio path. The producer (group strand) pushes PCM into
+    // a lock-free SPSC ring and never touches the disk; a dedicated thread gathers it into
+    // large aligned blocks, writes them, and patches the header when the file is closed.
+    // FLAC is encoded on the same thread, streaming, with memory bounded by one encode chunk.
+    // A write error (e.g. ENOSPC) fails the file: the rest of its data is dropped and counted,
+    // and at close it is renamed to <path>.failed rather than given a header that lies.
+    class AsyncFileWriter {
+    public:
+        static constexpr size_t kBlockBytes = 64 * 1024;    // Write granularity (and O_DIRECT alignment unit)
+        static constexpr size_t kEncodeFrames = 4096;       // FLAC encode chunk (frames per call)
+        static constexpr unsigned kFlacCompressionLevel = 5;
+
+        AsyncFileWriter(size_t queue_samples = 512 * 1024, bool direct_io = false);
+        ~AsyncFileWriter();
+
+        // All three are non-blocking; the file work happens later on the writer thread
+        void Open(const std::string& path, int sample_rate, int channels, FileFormat format = FileFormat::WAV);
+        void Write(const int16_t* data, size_t count);
+        void Close();
+
+        const FileWriterStats& GetStats() const { return stats_; }
+
+        // Takes effect from the next Open()
+        void SetDirectIO(bool direct_io) { direct_io_ = direct_io; }
+
+        // False when built without libFLAC
+        static bool SupportsFlac();
+
+    private:
+        enum class OpType { OPEN, CLOSE, STOP };
+
+        struct Op {
+            OpType type;
+            size_t data_end;        // Ring position that belongs to the file before this op
+            std::string path;
+            int sample_rate = 0;
+            int channels = 0;
+            FileFormat format = FileFormat::WAV;
+
+            Op(OpType t, size_t end) : type(t), data_end(end) {}
+        };
+
+        SPSCRingBuffer<int16_t> ring_;
+        std::atomic<bool> direct_io_;
+        FileWriterStats stats_;
+
+        // Control ops are rare (open/close), so a mutex is fine here
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<Op> ops_;
+
+        std::thread thread_;
+
+        // Writer thread state
+        int fd_ = -1;
+        bool fd_direct_ = false;
+        bool failed_ = false;               // A write to this file failed; nothing more goes to disk
+        std::string path_;
+        uint64_t file_bytes_ = 0;
+        uint8_t* staging_ = nullptr;
+        size_t staging_used_ = 0;
+
+        // FLAC encoder state (writer thread only)
+        void* flac_encoder_ = nullptr;
+        int channels_ = 1;
+        std::vector<int16_t> encode_in_;
+        std::vector<int32_t> encode_buf_;
+
+        friend struct FlacCallbacks;
+
+        void PushOp(Op op);
+        void WriterLoop();
+        void Drain(size_t data_end);
+        void FlushStaging(bool final_block);
+        void OpenFile(const Op& op);
+        void CloseFile();
+        void MarkFailed();
+        void AppendBytes(const uint8_t* data, size_t bytes);
+        bool SeekTo(uint64_t offset);
+        void EncodeFlac(size_t samples);
+    };
+}
@@ -0,0 +1,194 @@
+#include "AudioDecoder.h"
+#include <algorithm>
+#include <iostream>
+
+#ifdef BOWW_HAVE_OPUS
+    #include <opus/opus.h>
+#endif
+
+namespace boww {
+
+    static constexpr int kMaxOpusFrameMs = 120;         // Longest frame Opus can carry
+    static constexpr uint32_t kMaxConcealFrames = 5;    // Beyond this, a gap is a gap
+
+    const char* IngestCodecName(IngestCodec codec) {
+        switch (codec) {
+            case IngestCodec::IMA_ADPCM: return "adpcm";
+            case IngestCodec::OPUS: return "opus";
+            default: return "pcm";
+        }
+    }
+
+    bool ParseIngestCodec(const std::string& name, IngestCodec& codec) {
+        if (name == "pcm") codec = IngestCodec::PCM16;
+        else if (name == "adpcm") codec = IngestCodec::IMA_ADPCM;
+        else if (name == "opus") codec = IngestCodec::OPUS;
+        else return false;
+        return true;
+    }
+
+    bool IsIngestCodecSupported(IngestCodec codec) {
+#ifdef BOWW_HAVE_OPUS
+        (void)codec;
+        return true;
+#else
+        return codec != IngestCodec::OPUS;
+#endif
+    }
+
+    AudioDecoder::AudioDecoder(IngestCodec codec, int sample_rate, int channels)
+        : codec_(codec), sample_rate_(sample_rate), channels_(channels)
+    {
+#ifdef BOWW_HAVE_OPUS
+        if (codec_ == IngestCodec::OPUS) {
+            int err = OPUS_OK;
+            opus_ = opus_decoder_create(sample_rate_, channels_, &err);
+            if (err != OPUS_OK) {
+                std::cerr << "[Decoder] Opus init failed: " << opus_strerror(err) << std::endl;
+                opus_ = nullptr;
+            }
+        }
+#endif
+    }
+
+    AudioDecoder::~AudioDecoder() {
+#ifdef BOWW_HAVE_OPUS
+        if (opus_) opus_decoder_destroy(static_cast<OpusDecoder*>(opus_));
+#endif
+    }
+
+    bool AudioDecoder::IsReady() const {
+        return codec_ != IngestCodec::OPUS || opus_ != nullptr;
+    }
+
+    bool AudioDecoder::Decode(const uint8_t* data, size_t size, std::vector<int16_t>& out) {
+        size_t pos = out.size();
+        switch (codec_) {
+            case IngestCodec::PCM16: {
+                out.resize(pos + size / sizeof(int16_t));
+                std::copy(data, data + (out.size() - pos) * sizeof(int16_t), reinterpret_cast<uint8_t*>(out.data() + pos));
+                return true;
+            }
+            case IngestCodec::IMA_ADPCM: {
+                if (size <= adpcm::HEADER_SIZE) return false;
+                out.resize(pos + 2 * (size - adpcm::HEADER_SIZE));
+                size_t n = adpcm::Decode(data, size, out.data() + pos);
+                out.resize(pos + n);
+                return n > 0;
+            }
+            case IngestCodec::OPUS: {
+#ifdef BOWW_HAVE_OPUS
+                if (!opus_) return false;
+                int max_frame = sample_rate_ * kMaxOpusFrameMs / 1000;
+                out.resize(pos + static_cast<size_t>(max_frame) * channels_);    // Capacity is kept across calls
+                int n = opus_decode(static_cast<OpusDecoder*>(opus_), data, static_cast<opus_int32>(size), out.data() + pos, max_frame, 0);
+                if (n < 0) {
+                    out.resize(pos);
+                    return false;
+                }
+                out.resize(pos + static_cast<size_t>(n) * channels_);
+                last_frame_samples_ = n;
+                return true;
+#else
+                return false;
+#endif
+            }
+        }
+        return false;
+    }
+
+    PcmView AudioDecoder::DecodeFrame(const uint8_t* data, size_t size, uint32_t lost) {
+        frame_.clear();
+        if (lost) Conceal(lost, frame_);
+        if (!Decode(data, size, frame_)) return PcmView();
+        return PcmView(frame_);
+    }
+
+    void AudioDecoder::Conceal(uint32_t frames, std::vector<int16_t>& out) {
+#ifdef BOWW_HAVE_OPUS
+        if (codec_ != IngestCodec::OPUS || !opus_ || last_frame_samples_ == 0) return;
+        frames = std::min(frames, kMaxConcealFrames);
+        for (uint32_t i = 0; i < frames; ++i) {
+            size_t pos = out.size();
+            out.resize(pos + static_cast<size_t>(last_frame_samples_) * channels_);
+            int n = opus_decode(static_cast<OpusDecoder*>(opus_), nullptr, 0, out.data() + pos, last_frame_samples_, 0);
+            out.resize(pos + static_cast<size_t>(std::max(n, 0)) * channels_);
+        }
+#else
+        (void)frames;
+        (void)out;
+#endif
+    }
+
+    namespace adpcm {
+
+        static const int16_t kStepTable[89] = {
+            7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+            50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+            253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+            1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+            3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+            12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+        };
+
+        static const int8_t kIndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+        // One decode step; the encoder runs the same step so both sides track the same predictor
+        static inline void Step(int code, int& predictor, int& step_index) {
+            int step = kStepTable[step_index];
+            int diff = step >> 3;
+            if (code & 4) diff += step;
+            if (code & 2) diff += step >> 1;
+            if (code & 1) diff += step >> 2;
+            predictor += (code & 8) ? -diff : diff;
+            predictor = std::clamp(predictor, -32768, 32767);
+            step_index = std::clamp(step_index + kIndexTable[code & 7], 0, 88);
+        }
+
+        static inline int EncodeSample(int sample, EncoderState& state) {
+            int step = kStepTable[state.step_index];
+            int diff = sample - state.predictor;
+            int code = 0;
+            if (diff < 0) {
+                code = 8;
+                diff = -diff;
+            }
+            if (diff >= step) { code |= 4; diff -= step; }
+            if (diff >= (step >> 1)) { code |= 2; diff -= step >> 1; }
+            if (diff >= (step >> 2)) { code |= 1; }
+            Step(code, state.predictor, state.step_index);
+            return code;
+        }
+
+        size_t Encode(const int16_t* in, size_t count, uint8_t* out, EncoderState& state) {
+            int16_t predictor = static_cast<int16_t>(state.predictor);
+            out[0] = static_cast<uint8_t>(predictor & 0xFF);
+            out[1] = static_cast<uint8_t>((predictor >> 8) & 0xFF);
+            out[2] = static_cast<uint8_t>(state.step_index);
+            out[3] = 0;
+
+            size_t bytes = HEADER_SIZE;
+            for (size_t i = 0; i < count; i += 2) {
+                int lo = EncodeSample(in[i], state);
+                int hi = EncodeSample(in[std::min(i + 1, count - 1)], state);
+                out[bytes++] = static_cast<uint8_t>(lo | (hi << 4));
+            }
+            return bytes;
+        }
+
+        size_t Decode(const uint8_t* in, size_t size, int16_t* out) {
+            if (size <= HEADER_SIZE || in[2] > 88) return 0;
+            int predictor = static_cast<int16_t>(in[0] | (in[1] << 8));
+            int step_index = in[2];
+
+            size_t n = 0;
+            for (size_t i = HEADER_SIZE; i < size; ++i) {
+                Step(in[i] & 0x0F, predictor, step_index);
+                out[n++] = static_cast<int16_t>(predictor);
+                Step(in[i] >> 4, predictor, step_index);
+                out[n++] = static_cast<int16_t>(predictor);
+            }
+            return n;
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BoWWServerDefs.h"
+
+namespace boww {
+
+    // Compressed ingest, negotiated per client: hello carries {"codecs": ["opus", "adpcm"]}
+    // in preference order and hello_ack names the one the server picked ("pcm" if none fit).
+    // Each binary audio frame is then one codec frame; it is decoded to int16 PCM at the
+    // pipeline rate before GroupController::HandleAudioStream sees it.
+    enum class IngestCodec { PCM16, IMA_ADPCM, OPUS };
+
+    const char* IngestCodecName(IngestCodec codec);                 // "pcm", "adpcm", "opus"
+    bool ParseIngestCodec(const std::string& name, IngestCodec& codec);
+    bool IsIngestCodecSupported(IngestCodec codec);                 // Opus needs libopus at build time
+
+    // Per-session decoder, built for the session's group format (rate, channels). State (Opus)
+    // and the output buffer live as long as the decoder, so steady-state decoding does not
+    // allocate. Not thread-safe: one decoder is only ever used on one group strand.
+    class AudioDecoder {
+    public:
+        AudioDecoder(IngestCodec codec, int sample_rate, int channels);
+        ~AudioDecoder();
+
+        AudioDecoder(const AudioDecoder&) = delete;
+        AudioDecoder& operator=(const AudioDecoder&) = delete;
+
+        IngestCodec GetCodec() const { return codec_; }
+        int GetSampleRate() const { return sample_rate_; }
+        int GetChannels() const { return channels_; }
+        bool IsReady() const;
+
+        // Appends the decoded frame to out; false on a corrupt frame (out unchanged)
+        bool Decode(const uint8_t* data, size_t size, std::vector<int16_t>& out);
+
+        // Appends concealment audio for frames that never arrived (Opus PLC; no-op otherwise)
+        void Conceal(uint32_t frames, std::vector<int16_t>& out);
+
+        // Conceals `lost` missing frames, then decodes this one, into the decoder's own buffer.
+        // The view is valid until the next call; empty on a corrupt frame.
+        PcmView DecodeFrame(const uint8_t* data, size_t size, uint32_t lost);
+
+    private:
+        IngestCodec codec_;
+        int sample_rate_;
+        int channels_;
+        void* opus_ = nullptr;          // OpusDecoder*, only with BOWW_HAVE_OPUS
+        int last_frame_samples_ = 0;    // Per channel, for PLC
+        std::vector<int16_t> frame_;    // DecodeFrame output
+    };
+
+    // IMA-ADPCM framing: every frame is self-contained so a lost frame never desyncs the next.
+    //   offset  size  field
+    //   0       2     predictor before the first sample (int16, little-endian)
+    //   2       1     step index (0..88)
+    //   3       1     reserved (0)
+    //   4       ...   4-bit codes, two samples per byte, low nibble first
+    // A frame of N bytes decodes to 2 * (N - 4) samples, so frames carry an even sample count.
+    namespace adpcm {
+
+        constexpr size_t HEADER_SIZE = 4;
+
+        // Running encoder state, carried from frame to frame
+        struct EncoderState {
+            int predictor = 0;
+            int step_index = 0;
+        };
+
+        inline size_t EncodedSize(size_t samples) { return HEADER_SIZE + (samples + 1) / 2; }
+
+        // count is rounded up to even by repeating the last sample; returns bytes written
+        size_t Encode(const int16_t* in, size_t count, uint8_t* out, EncoderState& state);
+
+        // Returns samples written to out (room for 2 * (size - 4)), 0 if the frame is malformed
+        size_t Decode(const uint8_t* in, size_t size, int16_t* out);
+    }
+}
@@ -1,8 +1,10 @@
 #pragma once
 #include "BoWWServerDefs.h"
+#include "AsyncFileWriter.h"
+#include "AlsaPlayback.h"
+#include <memory>
 #include <vector>
 #include <mutex>
-#include <fstream>
 #include <string>
 
 namespace boww {
@@ -13,19 +15,29 @@ namespace boww {
         ~AudioOutputRouter();
 
         bool OpenStream(const std::string& source_client_guid);
-        void WriteChunk(const std::vector<int16_t>& data);
+        void WriteChunk(const std::vector<int16_t>& data) { WriteChunk(data.data(), data.size()); }
+        void WriteChunk(const int16_t* data, size_t count);     // count: interleaved samples, whole frames
         void CloseStream();
+        void Reconfigure(const GroupConfig& config);    // Only between streams
         bool IsBusy() const;
+        const FileWriterStats& GetWriterStats() const { return file_writer_.GetStats(); }
+        const PlaybackStats& GetPlaybackStats() const { return *playback_stats_; }
 
     private:
         GroupConfig config_;
         bool is_busy_ = false;
-        bool using_fallback_ = false;
 
-        std::ofstream wav_file_handle_;
-        void* alsa_handle_ = nullptr; 
+        // File output is queued to a writer thread; nothing here touches the disk
+        AsyncFileWriter file_writer_;
+        bool recording_to_file_ = false;
+
+        // ALSA output is one source in the device's shared mixer (one mixer per device name)
+        std::shared_ptr<PlaybackStats> playback_stats_ = std::make_shared<PlaybackStats>();
+        std::shared_ptr<AlsaPlayback> playback_;
+        std::shared_ptr<AlsaPlayback::Source> source_;
         std::mutex mutex_;
         
-        std::string GenerateFilename(const std::string& guid);
+        bool OpenFile(const std::string& source_client_guid);
+        std::string GenerateFilename(const std::string& guid, const std::string& extension);
     };
 }
@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace boww {
+
+    // Optional binary framing, negotiated with {"type":"hello", ..., "binary": 1}.
+    // The server answers {"type":"hello_ack","binary":1}; from then on every binary
+    // WebSocket frame in either direction starts with this 16-byte header.
+    // Old clients never ask, and keep plain JSON control + raw PCM frames.
+    //
+    //   offset  size  field
+    //   0       1     magic 'W'
+    //   1       1     type (BinaryType)
+    //   2       2     reserved (0)
+    //   4       4     sequence number, per sender, +1 per frame
+    //   8       8     capture timestamp, microseconds, sender's monotonic clock
+    //   16      ...   payload: AUDIO = int16 PCM, CONFIDENCE = float32 score, others empty
+    //
+    // All fields are little-endian (every platform we build for is).
+    namespace Binary {
+
+        constexpr uint8_t MAGIC = 'W';
+        constexpr size_t HEADER_SIZE = 16;
+
+        enum class Type : uint8_t {
+            AUDIO = 1,
+            CONFIDENCE = 2,
+            CONF_REC = 3,
+            STOP = 4
+        };
+
+        struct Header {
+            Type type = Type::AUDIO;
+            uint32_t seq = 0;
+            uint64_t timestamp_us = 0;
+        };
+
+        inline uint64_t NowMicros() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        inline void Encode(const Header& h, uint8_t* out) {
+            out[0] = MAGIC;
+            out[1] = static_cast<uint8_t>(h.type);
+            out[2] = 0;
+            out[3] = 0;
+            std::memcpy(out + 4, &h.seq, 4);
+            std::memcpy(out + 8, &h.timestamp_us, 8);
+        }
+
+        // False if the frame is too short or not ours
+        inline bool Decode(const void* data, size_t size, Header& h) {
+            const uint8_t* in = static_cast<const uint8_t*>(data);
+            if (size < HEADER_SIZE || in[0] != MAGIC) return false;
+            h.type = static_cast<Type>(in[1]);
+            std::memcpy(&h.seq, in + 4, 4);
+            std::memcpy(&h.timestamp_us, in + 8, 8);
+            return true;
+        }
+    }
+}
@@ -1,20 +1,29 @@
 #include "BoWWServer.h"
+#include "DSPKernels.h"
 #include <iostream>
 #include <random>
 #include <sstream>
 #include <fstream>
 #include <cstring> 
+#include <algorithm>
+#include <sys/resource.h>
 
 namespace boww {
 
-    BoWWServer::BoWWServer(bool debug_mode) 
-        : vad_engine_(debug_mode), debug_mode_(debug_mode) 
+    BoWWServer::BoWWServer(const ServerOptions& options) 
+        : vad_engine_(options.debug_mode), 
+          vad_scheduler_(vad_engine_, options.vad_max_batch, options.vad_batch_deadline_us, options.vad_workers, options.vad_max_queued),
+          debug_mode_(options.debug_mode), io_threads_(options.io_threads) 
     {
+        if (io_threads_ <= 0) {
+            io_threads_ = std::max(1u, std::thread::hardware_concurrency());
+        }
+
         // Logging
         endpoint_.clear_access_channels(websocketpp::log::alevel::all); 
         endpoint_.set_error_channels(websocketpp::log::elevel::all);    
 
-        if (debug_mode) {
+        if (debug_mode_) {
             endpoint_.set_access_channels(websocketpp::log::alevel::all);
             std::cout << "[Server] DEBUG MODE ENABLED" << std::endl;
         } else {
@@ -30,6 +39,7 @@ namespace boww {
         endpoint_.set_open_handler(bind(&BoWWServer::OnOpen, this, _1));
         endpoint_.set_close_handler(bind(&BoWWServer::OnClose, this, _1));
         endpoint_.set_message_handler(bind(&BoWWServer::OnMessage, this, _1, _2));
+        endpoint_.set_http_handler(bind(&BoWWServer::OnHttp, this, _1));
 
         if (!mdns_service_.Start("BoWW-Server", 9002)) {
             std::cerr << "[Server] Failed to start mDNS." << std::endl;
@@ -38,13 +48,19 @@ namespace boww {
         if (!vad_engine_.Initialize("../models/silero_vad.onnx")) {
             std::cerr << "[Server] WARNING: VAD Model load failed." << std::endl;
         }
+        vad_scheduler_.Start();
+        std::cout << "[Server] DSP kernels: " << dsp::ActiveISA() << std::endl;
     }
 
     BoWWServer::~BoWWServer() {
         running_ = false;
+        config_manager_.StopWatching();
         mdns_service_.Stop();
-        if (ticker_thread_.joinable()) ticker_thread_.join();
         endpoint_.stop();
+        vad_scheduler_.Stop();
+        for (auto& t : io_pool_) {
+            if (t.joinable()) t.join();
+        }
     }
 
     void BoWWServer::Run(uint16_t port) {
@@ -58,19 +74,29 @@ namespace boww {
         config_manager_.StartWatching();
 
         running_ = true;
-        ticker_thread_ = std::thread(&BoWWServer::TickerLoop, this);
 
         endpoint_.listen(port);
         endpoint_.start_accept();
         
-        std::cout << "[Server] BoWW Server v1.0 running on port " << port << std::endl;
+        std::cout << "[Server] BoWW Server v1.0 running on port " << port 
+                  << " (" << io_threads_ << " I/O threads)" << std::endl;
+
+        // Extra workers share the io_service with this thread. Per-connection
+        // ordering is kept by websocketpp, per-group ordering by the group strand.
+        for (int i = 1; i < io_threads_; ++i) {
+            io_pool_.emplace_back([this]() { endpoint_.run(); });
+        }
         endpoint_.run();
     }
 
     void BoWWServer::OnOpen(ConnectionHdl hdl) {
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        websocketpp::lib::error_code ec;
+        auto con = endpoint_.get_con_from_hdl(hdl, ec);
+        if (!con) return;
+
         auto session = std::make_shared<ClientSession>(hdl, this);
-        sessions_[hdl] = session;
+        con->session = session;
+        sessions_active_++;
 
         std::string temp_id = GenerateTempID();
         session->AssignTempID(temp_id);
@@ -86,35 +112,209 @@ namespace boww {
     }
 
     void BoWWServer::OnClose(ConnectionHdl hdl) {
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
-        if (sessions_.count(hdl)) {
-            auto session = sessions_[hdl];
-            std::cout << "[Server] Disconnect: " << session->GetID() << std::endl;
-            sessions_.erase(hdl);
+        websocketpp::lib::error_code ec;
+        auto con = endpoint_.get_con_from_hdl(hdl, ec);
+        if (!con || !con->session) return;
+        std::cout << "[Server] Disconnect: " << con->session->GetID() << std::endl;
+        if (auto group = con->session->GetGroupController()) group->RemoveMember(con->session);
+        {
+            // Only live connections can be onboarded; dropping it here also lets group weak_ptrs expire
+            std::lock_guard<std::mutex> tlock(temp_id_mutex_);
+            temp_id_map_.erase(con->session->GetTempID());
         }
+        con->session.reset();
+        sessions_active_--;
     }
 
     void BoWWServer::OnMessage(ConnectionHdl hdl, ServerType::message_ptr msg) {
-        std::shared_ptr<ClientSession> session;
-        {
-            std::lock_guard<std::mutex> lock(sessions_mutex_);
-            if (sessions_.find(hdl) == sessions_.end()) return;
-            session = sessions_[hdl];
-        }
+        websocketpp::lib::error_code ec;
+        auto con = endpoint_.get_con_from_hdl(hdl, ec);
+        if (!con || !con->session) return;
+        const std::shared_ptr<ClientSession>& session = con->session;
 
         if (msg->get_opcode() == websocketpp::frame::opcode::text) {
             HandleTextPacket(session, msg->get_payload());
         }
         else if (msg->get_opcode() == websocketpp::frame::opcode::binary) {
             if (!session->IsAuthenticated()) return; 
-            std::string group_name = session->GetGroup();
-            if (groups_.count(group_name)) {
-                const std::string& payload = msg->get_payload();
-                std::vector<int16_t> pcm_data(payload.size() / 2);
-                std::memcpy(pcm_data.data(), payload.data(), payload.size());
-                groups_[group_name]->HandleAudioStream(session, pcm_data);
+
+            AudioFrame frame;
+            float score = 0.0f;
+            switch (ParseBinary(*session, msg->get_payload(), frame, score)) {
+                case FrameKind::CONFIDENCE:
+                    HandleConfidence(session, score);
+                    break;
+                case FrameKind::AUDIO:
+                    if (auto group = GroupFor(session)) DispatchAudio(group, session, msg, frame);
+                    break;
+                case FrameKind::IGNORED:
+                    break;
+            }
+        }
+    }
+
+    // Binary-framed clients prefix every frame with a header; legacy clients send bare PCM
+    BoWWServer::FrameKind BoWWServer::ParseBinary(ClientSession& session, const std::string& payload, AudioFrame& frame, float& score) {
+        frame = AudioFrame();
+        if (!session.UsesBinaryProtocol()) return FrameKind::AUDIO;
+
+        Binary::Header header;
+        if (!Binary::Decode(payload.data(), payload.size(), header)) return FrameKind::IGNORED;
+        frame.lost = session.TrackFrame(header, Binary::NowMicros());
+
+        if (header.type == Binary::Type::CONFIDENCE) {
+            if (payload.size() < Binary::HEADER_SIZE + sizeof(float)) return FrameKind::IGNORED;
+            std::memcpy(&score, payload.data() + Binary::HEADER_SIZE, sizeof(float));
+            return FrameKind::CONFIDENCE;
+        }
+        if (header.type != Binary::Type::AUDIO) return FrameKind::IGNORED;
+        frame.offset = Binary::HEADER_SIZE;
+        frame.framed = true;
+        return FrameKind::AUDIO;
+    }
+
+    void BoWWServer::DispatchAudio(const std::shared_ptr<GroupController>& group, const std::shared_ptr<ClientSession>& session,
+                                   ServerType::message_ptr msg, const AudioFrame& frame) {
+        if (frame.framed) group->RecordNetwork(frame.lost, session->GetJitterMicros());
+
+        // Serialize DSP + VAD per group; different groups run in parallel on the pool.
+        // The handler keeps msg alive, so the DSP reads the frame payload in place.
+        // It also keeps the decoder that was current for this frame: a later hello
+        // installs a new one rather than changing this one under a queued handler.
+        size_t offset = frame.offset;
+        uint32_t lost = frame.lost;
+        group->GetStrand().post([group, session, msg = std::move(msg), offset, lost, decoder = session->GetDecoder()]() {
+            const std::string& payload = msg->get_payload();
+            const char* data = payload.data() + offset;
+            size_t size = payload.size() - offset;
+            if (!decoder) {
+                group->HandleAudioStream(session, PcmView(reinterpret_cast<const int16_t*>(data), size / sizeof(int16_t)));
+                return;
             }
+            PcmView pcm = decoder->DecodeFrame(reinterpret_cast<const uint8_t*>(data), size, lost);
+            if (pcm.empty()) {
+                group->RecordDecodeError();
+                return;
+            }
+            group->HandleAudioStream(session, pcm);
+        });
+    }
+
+    // Plain HTTP on the WebSocket port: GET /metrics returns Prometheus text format
+    void BoWWServer::OnHttp(ConnectionHdl hdl) {
+        websocketpp::lib::error_code ec;
+        auto con = endpoint_.get_con_from_hdl(hdl, ec);
+        if (!con) return;
+
+        if (con->get_resource() != "/metrics") {
+            con->set_status(websocketpp::http::status_code::not_found);
+            return;
         }
+
+        std::ostringstream os;
+        RenderMetrics(os);
+        con->set_status(websocketpp::http::status_code::ok);
+        con->replace_header("Content-Type", "text/plain; version=0.0.4");
+        con->set_body(os.str());
+    }
+
+    void BoWWServer::RenderMetrics(std::ostream& os) {
+        std::vector<std::shared_ptr<GroupController>> groups;
+        {
+            std::lock_guard<std::mutex> lock(groups_mutex_);
+            for (auto& [name, controller] : groups_) groups.push_back(controller);
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        double cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+        metrics::Header(os, "boww_sessions_active", "gauge", "Connected WebSocket sessions");
+        os << "boww_sessions_active " << sessions_active_.load() << '\n';
+        metrics::Header(os, "boww_process_cpu_seconds_total", "counter", "User + system CPU time");
+        os << "boww_process_cpu_seconds_total " << cpu << '\n';
+        metrics::Header(os, "boww_io_threads", "gauge", "WebSocket I/O threads (--threads)");
+        os << "boww_io_threads " << io_threads_ << '\n';
+
+        metrics::Header(os, "boww_vad_queue_chunks", "gauge", "Chunks waiting for a VAD worker");
+        os << "boww_vad_queue_chunks " << vad_scheduler_.GetQueueDepth() << '\n';
+
+        auto label = [](const GroupController& g) { return "group=\"" + g.GetName() + "\""; };
+        auto family = [&](const char* name, const char* type, const char* help, auto value) {
+            metrics::Header(os, name, type, help);
+            for (auto& g : groups) os << name << '{' << label(*g) << "} " << value(*g) << '\n';
+        };
+        auto relaxed = [](const auto& a) { return a.load(std::memory_order_relaxed); };
+
+        family("boww_frames_received_total", "counter", "Binary audio frames received",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().frames_received); });
+        family("boww_bytes_received_total", "counter", "Audio payload bytes received",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().bytes_received); });
+        family("boww_frames_dropped_total", "counter", "Frames from clients without the floor",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().frames_dropped); });
+        family("boww_vad_chunks_total", "counter", "512-sample chunks sent to VAD",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().chunks_processed); });
+        family("boww_ingest_buffer_samples", "gauge", "Samples waiting for a full VAD chunk",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().ingest_depth); });
+        family("boww_output_accumulator_samples", "gauge", "Samples held in the output jitter buffer",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().accumulator_fill); });
+        family("boww_jitter_target_seconds", "gauge", "Current playout target of the output jitter buffer",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().jitter_target_us) / 1e6; });
+        family("boww_jitter_underruns_total", "counter", "Times output playout ran dry waiting for the next frame (the jitter buffer then rebuffers)",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().jitter_underruns); });
+        family("boww_agc_gain", "gauge", "Current sidechain AGC gain",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().agc_gain); });
+        family("boww_vad_chunks_shed_total", "counter", "VAD chunks dropped because the stream's queue was full",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().vad_chunks_shed); });
+        family("boww_vad_channel", "gauge", "Input channel feeding the VAD (-1 = downmix)",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().vad_channel); });
+        family("boww_timer_wakeups_total", "counter", "Arbitration and no-voice timer firings (zero while the group is idle)",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().timer_wakeups); });
+        family("boww_frames_lost_total", "counter", "Sequence gaps seen from binary-framed clients",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().frames_lost); });
+        family("boww_decode_errors_total", "counter", "Compressed audio frames that failed to decode",
+               [&](const GroupController& g) { return relaxed(g.GetMetrics().decode_errors); });
+        family("boww_writer_queue_samples", "gauge", "Samples queued for the recording thread",
+               [&](const GroupController& g) { return relaxed(g.GetWriterStats().queued_samples); });
+        family("boww_writer_dropped_samples_total", "counter", "Samples lost because the recording queue was full or the file had failed",
+               [&](const GroupController& g) { return relaxed(g.GetWriterStats().dropped_samples); });
+        family("boww_writer_lost_bytes_total", "counter", "Recording bytes that failed to write (e.g. disk full)",
+               [&](const GroupController& g) { return relaxed(g.GetWriterStats().lost_bytes); });
+        family("boww_writer_failed_files_total", "counter", "Recordings closed after a write error (renamed *.failed)",
+               [&](const GroupController& g) { return relaxed(g.GetWriterStats().files_failed); });
+        family("boww_writer_bytes_total", "counter", "Bytes written to recordings",
+               [&](const GroupController& g) { return relaxed(g.GetWriterStats().bytes_written); });
+        family("boww_playback_queue_samples", "gauge", "Samples queued for the ALSA playback thread",
+               [&](const GroupController& g) { return relaxed(g.GetPlaybackStats().queued_samples); });
+        family("boww_playback_dropped_samples_total", "counter", "Samples lost because the playback queue was full",
+               [&](const GroupController& g) { return relaxed(g.GetPlaybackStats().dropped_samples); });
+        family("boww_playback_xruns_total", "counter", "ALSA underruns recovered by the playback thread",
+               [&](const GroupController& g) { return relaxed(g.GetPlaybackStats().xruns); });
+        family("boww_playback_open_failures_total", "counter", "ALSA device opens that failed, or devices lost mid-stream",
+               [&](const GroupController& g) { return relaxed(g.GetPlaybackStats().open_failures); });
+
+        auto histogram = [&](const char* name, const char* help, const Histogram& (*get)(const GroupController&)) {
+            metrics::Header(os, name, "histogram", help);
+            for (auto& g : groups) get(*g).Write(os, name, label(*g));
+        };
+        histogram("boww_vad_latency_seconds", "VAD submit to result, including batching wait",
+                  [](const GroupController& g) -> const Histogram& { return g.GetMetrics().vad_latency; });
+        // One series per resolution reason, so early decisions can be compared with timeouts
+        metrics::Header(os, "boww_arbitration_duration_seconds", "histogram", "First confidence score to arbitration decision");
+        for (auto& g : groups) {
+            for (auto reason : {ArbitrationReason::TIMEOUT, ArbitrationReason::ALL_REPORTED, ArbitrationReason::DECISIVE}) {
+                g->GetMetrics().arbitration_duration[static_cast<size_t>(reason)].Write(
+                    os, "boww_arbitration_duration_seconds", label(*g) + ",reason=\"" + ArbitrationReasonName(reason) + "\"");
+            }
+        }
+        histogram("boww_lock_to_first_write_seconds", "Arbitration decision to first output write",
+                  [](const GroupController& g) -> const Histogram& { return g.GetMetrics().lock_to_first_write; });
+        histogram("boww_timer_lateness_seconds", "Arbitration and no-voice timer deadline to handler running",
+                  [](const GroupController& g) -> const Histogram& { return g.GetMetrics().timer_lateness; });
+        histogram("boww_network_jitter_seconds", "Interarrival jitter of binary-framed clients (RFC 3550)",
+                  [](const GroupController& g) -> const Histogram& { return g.GetMetrics().network_jitter; });
+        histogram("boww_jitter_buffer_delay_seconds", "Time the oldest output sample waited in the jitter buffer",
+                  [](const GroupController& g) -> const Histogram& { return g.GetMetrics().jitter_delay; });
     }
 
     void BoWWServer::HandleTextPacket(std::shared_ptr<ClientSession> session, const std::string& payload) {
@@ -126,31 +326,68 @@ namespace boww {
                 std::string guid = j["guid"];
                 ClientInfo info;
                 if (config_manager_.IsGUIDValid(guid, info)) {
+                    // A repeated hello may move the session; arbitration only waits on current members
+                    if (auto previous = session->GetGroupController()) previous->RemoveMember(session);
                     session->SetGUID(guid, info.group_name);
+                    GroupConfig format;     // Defaults until the group exists
+                    if (auto group = GroupFor(session)) {
+                        SetPendingMember(session, "");
+                        group->AddMember(session);
+                        format = group->GetConfig();
+                    } else {
+                        SetPendingMember(session, info.group_name);
+                    }
+
+                    // Opt-in binary framing; only clients that see hello_ack switch over
+                    bool binary = false;
+                    if (j.contains("binary")) {
+                        const auto& b = j["binary"];
+                        binary = b.is_boolean() ? b.get<bool>() : (b.is_number() && b.get<int>() != 0);
+                    }
+                    session->SetBinaryProtocol(binary);
+
+                    // Compressed ingest: first codec in the client's list that this build can decode at
+                    // the group's own rate and channels, which is what HandleAudioStream expects
+                    session->SetCodec(IngestCodec::PCM16, format.sample_rate, format.channels);
+                    bool codec_requested = j.contains("codecs") && j["codecs"].is_array();
+                    if (codec_requested) {
+                        for (const auto& name : j["codecs"]) {
+                            IngestCodec c;
+                            if (!name.is_string() || !ParseIngestCodec(name.get<std::string>(), c) || !IsIngestCodecSupported(c)) continue;
+                            session->SetCodec(c, format.sample_rate, format.channels);
+                            if (session->GetCodec() == c) break;
+                        }
+                    }
+
+                    if (binary || codec_requested) {
+                        nlohmann::json ack = {{"type", Protocol::MSG_HELLO_ACK}};
+                        if (binary) ack["binary"] = 1;
+                        if (codec_requested) {
+                            ack["codec"] = IngestCodecName(session->GetCodec());
+                            ack["sample_rate"] = format.sample_rate;
+                            ack["channels"] = format.channels;
+                        }
+                        SendJSON(session->GetHandle(), ack);
+                    }
                 } else {
                     std::cout << "[Server] Client sent invalid GUID: " << guid << std::endl;
                 }
             }
             else if (type == Protocol::MSG_CONFIDENCE) {
                 if (!session->IsAuthenticated()) return;
-                float score = j["value"];
-                std::string group = session->GetGroup();
-                if (groups_.count(group)) {
-                    SendJSON(session->GetHandle(), {{"type", Protocol::MSG_CONF_REC}});
-                    groups_[group]->HandleConfidenceScore(session, score);
-                }
+                HandleConfidence(session, j["value"]);
             }
         } catch (const std::exception& e) {
             std::cerr << "[Server] JSON Parse Error: " << e.what() << std::endl;
         }
     }
 
-    void BoWWServer::TickerLoop() {
-        while (running_) {
-            for (auto& [name, controller] : groups_) {
-                if (controller) controller->OnTick();
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    void BoWWServer::HandleConfidence(const std::shared_ptr<ClientSession>& session, float score) {
+        if (!session->IsAuthenticated()) return;
+        auto group = GroupFor(session);
+        if (group) {
+            session->SendConfidenceReceived();
+            group->HandleConfidenceScore(session, score);
         }
     }
 
@@ -165,9 +402,53 @@ namespace boww {
     
     void BoWWServer::OnConfigGroupChanged(GroupConfig config) {
         std::cout << "[Server] Group Config Updated: " << config.name << std::endl;
-        if (groups_.find(config.name) == groups_.end()) {
-            groups_[config.name] = std::make_shared<GroupController>(config, vad_engine_, debug_mode_);
-        } 
+        std::lock_guard<std::mutex> lock(groups_mutex_);
+        auto it = groups_.find(config.name);
+        if (it == groups_.end()) {
+            auto group = std::make_shared<GroupController>(config, vad_scheduler_, endpoint_.get_io_service(), debug_mode_);
+            groups_[config.name] = group;
+            // Clients that said hello before the group existed are already connected members
+            auto pending = pending_members_.find(config.name);
+            if (pending != pending_members_.end()) {
+                for (const auto& member : pending->second) {
+                    if (auto session = member.lock()) group->AddMember(session);
+                }
+                pending_members_.erase(pending);
+            }
+        } else {
+            it->second->UpdateConfig(config);
+        }
+    }
+
+    std::shared_ptr<GroupController> BoWWServer::FindGroup(const std::string& name) {
+        std::lock_guard<std::mutex> lock(groups_mutex_);
+        auto it = groups_.find(name);
+        return (it != groups_.end()) ? it->second : nullptr;
+    }
+
+    // Files the session under the group its hello named (empty: none), dropping any earlier entry
+    void BoWWServer::SetPendingMember(const std::shared_ptr<ClientSession>& session, const std::string& group) {
+        std::lock_guard<std::mutex> lock(groups_mutex_);
+        for (auto it = pending_members_.begin(); it != pending_members_.end();) {
+            auto& members = it->second;
+            members.erase(std::remove_if(members.begin(), members.end(), [&](const std::weak_ptr<ClientSession>& m) {
+                auto s = m.lock();
+                return !s || s == session;
+            }), members.end());
+            it = members.empty() ? pending_members_.erase(it) : std::next(it);
+        }
+        if (group.empty()) return;
+        auto created = groups_.find(group);    // Created since the caller looked
+        if (created != groups_.end()) created->second->AddMember(session);
+        else pending_members_[group].push_back(session);
+    }
+
+    // Cached on the session after the first lookup; only the connection's own handlers call this
+    std::shared_ptr<GroupController> BoWWServer::GroupFor(const std::shared_ptr<ClientSession>& session) {
+        if (auto group = session->GetGroupController()) return group;
+        auto group = FindGroup(session->GetGroup());
+        if (group) session->AttachGroup(group);
+        return group;
     }
 
     void BoWWServer::SendJSON(ConnectionHdl hdl, const nlohmann::json& j) {
@@ -176,6 +457,12 @@ namespace boww {
         } catch (...) {}
     }
 
+    void BoWWServer::SendBinary(ConnectionHdl hdl, const void* data, size_t size) {
+        try {
+            endpoint_.send(hdl, data, size, websocketpp::frame::opcode::binary);
+        } catch (...) {}
+    }
+
     std::string BoWWServer::GenerateTempID() {
         static const char hex[] = "0123456789ABCDEF";
         std::string id = "temp-";
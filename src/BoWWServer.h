@@ -6,22 +6,35 @@
 #include <mutex>
 #include <thread>
 #include <set>
+#include <vector>
+#include <atomic>
 
 #include "BoWWServerDefs.h"
 #include "ConfigManager.h"
 #include "VADEngine.h"
+#include "VADScheduler.h"
 #include "GroupController.h"
 #include "ClientSession.h"
 #include "MDNSService.h"
 
 namespace boww {
 
-    using ServerType = websocketpp::server<websocketpp::config::asio>;
+    // Per-connection data lives on the websocketpp connection itself, so a frame
+    // reaches its session (and group) through the handle without any map lookup
+    struct SessionConnectionBase {
+        std::shared_ptr<ClientSession> session;     // Set in OnOpen, cleared in OnClose
+    };
+
+    struct ServerConfig : public websocketpp::config::asio {
+        typedef SessionConnectionBase connection_base;
+    };
+
+    using ServerType = websocketpp::server<ServerConfig>;
     using ConnectionHdl = websocketpp::connection_hdl;
 
     class BoWWServer {
     public:
-        BoWWServer(bool debug_mode = false);
+        BoWWServer(const ServerOptions& options = ServerOptions());
         ~BoWWServer();
 
         void Run(uint16_t port);
@@ -29,35 +42,53 @@ namespace boww {
         void OnOpen(ConnectionHdl hdl);
         void OnClose(ConnectionHdl hdl);
         void OnMessage(ConnectionHdl hdl, ServerType::message_ptr msg);
+        void OnHttp(ConnectionHdl hdl);
         void SendJSON(ConnectionHdl hdl, const nlohmann::json& j);
+        void SendBinary(ConnectionHdl hdl, const void* data, size_t size);
+
+        // The binary-message path of OnMessage, split out so boww_bench runs exactly this
+        // code: ParseBinary reads the frame header (if the session negotiated one) and
+        // DispatchAudio posts the frame to the group strand with the production handler.
+        enum class FrameKind { AUDIO, CONFIDENCE, IGNORED };
+        struct AudioFrame {
+            size_t offset = 0;      // Start of the audio in the payload
+            uint32_t lost = 0;      // Frames missing just before this one
+            bool framed = false;    // Came with a binary header
+        };
+        static FrameKind ParseBinary(ClientSession& session, const std::string& payload, AudioFrame& frame, float& score);
+        static void DispatchAudio(const std::shared_ptr<GroupController>& group, const std::shared_ptr<ClientSession>& session,
+                                  ServerType::message_ptr msg, const AudioFrame& frame);
 
     private:
         ServerType endpoint_;
         ConfigManager config_manager_;
         VADEngine vad_engine_;
+        VADScheduler vad_scheduler_;
         MDNSService mdns_service_;
         
         bool debug_mode_; 
+        int io_threads_;
         
         std::map<std::string, std::shared_ptr<GroupController>> groups_;
+        // Sessions whose hello named a group that does not exist yet; they become members
+        // when it is created. Guarded by groups_mutex_.
+        std::map<std::string, std::vector<std::weak_ptr<ClientSession>>> pending_members_;
+        std::mutex groups_mutex_;
         
-        struct HdlComparator {
-            bool operator()(const ConnectionHdl& a, const ConnectionHdl& b) const {
-                return std::owner_less<ConnectionHdl>()(a, b);
-            }
-        };
-        std::map<ConnectionHdl, std::shared_ptr<ClientSession>, HdlComparator> sessions_;
-        std::mutex sessions_mutex_;
-
         std::map<std::string, std::shared_ptr<ClientSession>> temp_id_map_;
         std::mutex temp_id_mutex_;
 
-        std::thread ticker_thread_;
-        bool running_ = false;
+        std::vector<std::thread> io_pool_;
+        std::atomic<bool> running_{false};
+        std::atomic<int> sessions_active_{0};
 
-        void TickerLoop();
+        std::shared_ptr<GroupController> FindGroup(const std::string& name);
+        std::shared_ptr<GroupController> GroupFor(const std::shared_ptr<ClientSession>& session);
+        void SetPendingMember(const std::shared_ptr<ClientSession>& session, const std::string& group);
         void HandleTextPacket(std::shared_ptr<ClientSession> session, const std::string& payload);
+        void HandleConfidence(const std::shared_ptr<ClientSession>& session, float score);
         std::string GenerateTempID();
+        void RenderMetrics(std::ostream& os);
         
         void OnConfigClientOnboarded(std::string temp_id, std::string new_guid, std::string group);
         void OnConfigGroupChanged(GroupConfig config);
@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <tuple>
+#include <cstdint>
+#include <cstddef>
 #include <nlohmann/json.hpp>
 
 namespace boww {
@@ -14,23 +17,86 @@ namespace boww {
         const std::string MSG_CONF_REC = "conf_rec";     
         const std::string MSG_STOP = "stop";             
         const std::string MSG_ASSIGN_ID = "assign_id";   
+        const std::string MSG_HELLO_ACK = "hello_ack";   // Sent when hello asks for binary framing or a codec
     }
 
-    enum class OutputType { ALSA, FILE };
+    enum class OutputType { ALSA, FILE, FLAC };
+
+    // How a multi-channel group feeds its single VAD stream (the recording keeps every channel)
+    enum class ChannelPolicy {
+        DOWNMIX,    // Average of all channels
+        FIXED,      // One configured channel (vad_channel)
+        BEST        // Loudest channel, with hysteresis so it does not flap
+    };
+
+    inline const char* ChannelPolicyName(ChannelPolicy policy) {
+        switch (policy) {
+            case ChannelPolicy::DOWNMIX: return "downmix";
+            case ChannelPolicy::FIXED: return "fixed";
+            default: return "best";
+        }
+    }
+
+    // Non-owning view over int16 PCM, e.g. straight over a WebSocket payload.
+    // The owner (message_ptr, vector, ...) must outlive the view.
+    struct PcmView {
+        const int16_t* data = nullptr;
+        size_t size = 0;
+
+        PcmView() = default;
+        PcmView(const int16_t* d, size_t n) : data(d), size(n) {}
+        PcmView(const std::vector<int16_t>& v) : data(v.data()), size(v.size()) {}
+
+        const int16_t* begin() const { return data; }
+        const int16_t* end() const { return data + size; }
+        bool empty() const { return size == 0; }
+    };
 
     struct GroupConfig {
         std::string name;
         int sample_rate = DEFAULT_SAMPLE_RATE;
         int channels = DEFAULT_CHANNELS;
         int arbitration_timeout_ms = 200;
+        float decisive_score = 0.0f;    // A score at or above this wins at once (0 = always wait)
         int vad_no_voice_ms = 1000;
+        int preroll_ms = 500;       // Candidate audio kept during arbitration (0 = off)
         OutputType output_type = OutputType::FILE;
         std::string output_target; 
         bool fallback_to_file_on_busy = true;
+        bool direct_io = false;     // Bypass the page cache for recordings (O_DIRECT)
+        ChannelPolicy channel_policy = ChannelPolicy::BEST;
+        int vad_channel = 0;        // Channel used by ChannelPolicy::FIXED
+        float mix_gain = 1.0f;      // This group's level in a shared ALSA device's mix (linear)
+        int jitter_min_ms = 20;     // Bounds for the adaptive output jitter buffer
+        int jitter_max_ms = 300;
     };
 
+    inline bool operator==(const GroupConfig& a, const GroupConfig& b) {
+        return std::tie(a.name, a.sample_rate, a.channels, a.arbitration_timeout_ms, a.decisive_score, a.vad_no_voice_ms,
+                        a.preroll_ms, a.output_type, a.output_target, a.fallback_to_file_on_busy, a.direct_io,
+                        a.channel_policy, a.vad_channel, a.mix_gain, a.jitter_min_ms, a.jitter_max_ms) ==
+               std::tie(b.name, b.sample_rate, b.channels, b.arbitration_timeout_ms, b.decisive_score, b.vad_no_voice_ms,
+                        b.preroll_ms, b.output_type, b.output_target, b.fallback_to_file_on_busy, b.direct_io,
+                        b.channel_policy, b.vad_channel, b.mix_gain, b.jitter_min_ms, b.jitter_max_ms);
+    }
+
     struct ClientInfo {
         std::string guid;
         std::string group_name;
     };
+
+    // Process-wide settings, filled from the command line in main.cpp
+    struct ServerOptions {
+        bool debug_mode = false;
+        int io_threads = 1;      // asio worker threads (0 = one per core)
+        int vad_max_batch = 8;            // Max streams stacked into one Silero run
+        int vad_batch_deadline_us = 2000; // Max wait for a batch to fill
+        int vad_workers = 1;              // Pinned inference threads (0 = one per core)
+        int vad_max_queued = 8;           // Chunks a stream may have waiting before the oldest is shed
+
+        // Offline replay (--replay): run WAV files through the pipeline instead of serving
+        std::string replay_path;
+        std::string replay_group;         // Group settings to use from clients.yaml
+        int replay_jobs = 0;              // Parallel files (0 = one per core)
+    };
 }
@@ -0,0 +1,92 @@
+#include "ChannelSelector.h"
+#include "DSPKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace boww {
+
+    static constexpr size_t kMaxBlockFrames = 1024;     // Plane scratch per channel
+    static constexpr double kEnergyTauFrames = 2048.0;  // Smoothing time constant, so weight follows block length
+    static constexpr double kSwitchRatio = 2.0;         // About 3 dB louder before BEST moves
+
+    ChannelSelector::ChannelSelector(int channels, ChannelPolicy policy, int vad_channel)
+        : channels_(std::max(1, channels)), policy_(policy), vad_channel_(std::clamp(vad_channel, 0, std::max(1, channels) - 1))
+    {
+        carry_.reserve(channels_);
+        if (policy_ == ChannelPolicy::BEST && channels_ > 1) {
+            planes_.assign(channels_, std::vector<int16_t>(kMaxBlockFrames));
+            for (auto& p : planes_) plane_ptrs_.push_back(p.data());
+        }
+        Reset();
+    }
+
+    int ChannelSelector::GetActiveChannel() const {
+        switch (policy_) {
+            case ChannelPolicy::DOWNMIX: return channels_ == 1 ? 0 : -1;
+            case ChannelPolicy::FIXED: return vad_channel_;
+            default: return active_;
+        }
+    }
+
+    void ChannelSelector::Reset() {
+        carry_.clear();
+        energy_.assign(channels_, 0.0);
+        active_ = vad_channel_;     // BEST starts from the configured channel until one stands out
+    }
+
+    void ChannelSelector::Process(const int16_t* in, size_t count, std::vector<int16_t>& out) {
+        if (IsPassthrough()) {
+            out.insert(out.end(), in, in + count);
+            return;
+        }
+
+        if (!carry_.empty()) {
+            size_t take = std::min(count, static_cast<size_t>(channels_) - carry_.size());
+            carry_.insert(carry_.end(), in, in + take);
+            in += take;
+            count -= take;
+            if (carry_.size() < static_cast<size_t>(channels_)) return;
+            ProcessFrames(carry_.data(), 1, out);
+            carry_.clear();
+        }
+
+        size_t frames = count / channels_;
+        ProcessFrames(in, frames, out);
+        carry_.insert(carry_.end(), in + frames * channels_, in + count);
+    }
+
+    void ChannelSelector::ProcessFrames(const int16_t* in, size_t frames, std::vector<int16_t>& out) {
+        if (frames == 0) return;
+        size_t pos = out.size();
+        out.resize(pos + frames);
+        int16_t* dst = out.data() + pos;
+
+        if (policy_ == ChannelPolicy::DOWNMIX) {
+            dsp::Downmix(in, frames, channels_, dst);
+            return;
+        }
+        if (policy_ == ChannelPolicy::FIXED) {
+            for (size_t f = 0; f < frames; ++f) dst[f] = in[f * channels_ + vad_channel_];
+            return;
+        }
+
+        // BEST: one deinterleave, a SumSquares per plane and a copy of the chosen plane.
+        // The decision applies from the block that made it, so a switch lands on the onset.
+        while (frames > 0) {
+            size_t block = std::min(frames, kMaxBlockFrames);
+            dsp::Deinterleave(in, block, channels_, plane_ptrs_.data());
+            const double keep = std::exp(-static_cast<double>(block) / kEnergyTauFrames);
+            for (int c = 0; c < channels_; ++c) {
+                double mean_square = static_cast<double>(dsp::SumSquares(plane_ptrs_[c], block)) / static_cast<double>(block);
+                energy_[c] = keep * energy_[c] + (1.0 - keep) * mean_square;
+            }
+            int loudest = static_cast<int>(std::max_element(energy_.begin(), energy_.end()) - energy_.begin());
+            if (loudest != active_ && energy_[loudest] > kSwitchRatio * energy_[active_]) active_ = loudest;
+
+            std::copy(plane_ptrs_[active_], plane_ptrs_[active_] + block, dst);
+            in += block * channels_;
+            dst += block;
+            frames -= block;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BoWWServerDefs.h"
+
+namespace boww {
+
+    // First stage of the detection sidechain for multi-channel groups: interleaved frames
+    // in, one mono stream out for the resampler, AGC and a single VAD state. The output
+    // path never comes through here, so recordings keep every channel.
+    //   DOWNMIX  average of all channels (dsp::Downmix)
+    //   FIXED    vad_channel only
+    //   BEST     loudest channel by smoothed energy, with hysteresis so it does not flap
+    // Frames may arrive split mid-frame (pre-roll spans); the partial frame is carried over.
+    class ChannelSelector {
+    public:
+        ChannelSelector(int channels, ChannelPolicy policy, int vad_channel);
+
+        int GetChannels() const { return channels_; }
+        ChannelPolicy GetPolicy() const { return policy_; }
+        int GetVadChannel() const { return vad_channel_; }
+        bool IsPassthrough() const { return channels_ == 1; }
+
+        // Channel BEST is listening to (vad_channel for FIXED, -1 for DOWNMIX)
+        int GetActiveChannel() const;
+
+        // Appends one mono sample per complete frame in the count new samples to out
+        void Process(const int16_t* in, size_t count, std::vector<int16_t>& out);
+
+        // Upper bound on the output for count input samples
+        size_t MaxOutput(size_t count) const { return count / channels_ + 1; }
+
+        // Drop the partial frame and the energy history (new stream)
+        void Reset();
+
+    private:
+        int channels_;
+        ChannelPolicy policy_;
+        int vad_channel_;
+        int active_ = 0;
+
+        std::vector<int16_t> carry_;                // Partial frame from the previous call
+        std::vector<std::vector<int16_t>> planes_;  // BEST only: one plane per channel
+        std::vector<int16_t*> plane_ptrs_;
+        std::vector<double> energy_;                // BEST only: smoothed mean square per channel
+
+        void ProcessFrames(const int16_t* in, size_t frames, std::vector<int16_t>& out);
+    };
+}
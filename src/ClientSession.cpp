@@ -2,11 +2,15 @@
 #include "BoWWServer.h"
 #include <iostream>
 #include <chrono>
+#include <atomic>
+#include <cstdlib>
 
 namespace boww {
 
+    static std::atomic<SessionID> next_session_id{1};
+
     ClientSession::ClientSession(websocketpp::connection_hdl connection_handle, BoWWServer* server)
-        : connection_handle_(connection_handle), server_context_(server) 
+        : connection_handle_(connection_handle), session_id_(next_session_id++), server_context_(server) 
     {
         last_voice_ts_ = std::chrono::steady_clock::now();
     }
@@ -15,16 +19,18 @@ namespace boww {
         temp_id_ = temp_id;
         guid_ = "";
         group_name_ = "";
+        group_.reset();
     }
 
     void ClientSession::SetGUID(const std::string& guid, const std::string& group) {
         guid_ = guid;
         group_name_ = group;
+        group_.reset();
         temp_id_ = ""; 
         std::cout << "[Session] Authenticated GUID: " << guid << " in Group: " << group << std::endl;
     }
 
-    std::string ClientSession::GetID() const {
+    const std::string& ClientSession::GetID() const {
         return guid_.empty() ? temp_id_ : guid_;
     }
 
@@ -32,7 +38,7 @@ namespace boww {
         return !guid_.empty();
     }
 
-    std::string ClientSession::GetGroup() const {
+    const std::string& ClientSession::GetGroup() const {
         return group_name_;
     }
 
@@ -61,9 +67,65 @@ namespace boww {
         }
     }
 
+    void ClientSession::SetCodec(IngestCodec codec, int sample_rate, int channels) {
+        // The old decoder is not reused: handlers posted before this hello still hold it
+        decoder_.reset();
+        if (codec != IngestCodec::PCM16) {
+            auto decoder = std::make_shared<AudioDecoder>(codec, sample_rate, channels);
+            if (decoder->IsReady()) decoder_ = std::move(decoder);
+            else codec = IngestCodec::PCM16;     // e.g. Opus at 44.1 kHz or more than 2 channels
+        }
+        codec_ = codec;
+    }
+
     void ClientSession::SendStopSignal() {
+        if (binary_) {
+            SendControl(Binary::Type::STOP);
+            return;
+        }
         nlohmann::json j;
         j["type"] = Protocol::MSG_STOP;
         SendJSON(j);
     }
+
+    void ClientSession::SendConfidenceReceived() {
+        if (binary_) {
+            SendControl(Binary::Type::CONF_REC);
+            return;
+        }
+        SendJSON({{"type", Protocol::MSG_CONF_REC}});
+    }
+
+    // Control frames are a bare header; may be called from any thread
+    void ClientSession::SendControl(Binary::Type type) {
+        if (!server_context_) return;
+        Binary::Header header;
+        header.type = type;
+        header.seq = send_seq_++;
+        header.timestamp_us = Binary::NowMicros();
+        uint8_t frame[Binary::HEADER_SIZE];
+        Binary::Encode(header, frame);
+        server_context_->SendBinary(connection_handle_, frame, sizeof(frame));
+    }
+
+    uint32_t ClientSession::TrackFrame(const Binary::Header& header, uint64_t arrival_us) {
+        int64_t transit = static_cast<int64_t>(arrival_us - header.timestamp_us);
+        if (!have_seq_) {
+            have_seq_ = true;
+            last_seq_ = header.seq;
+            last_transit_us_ = transit;
+            return 0;
+        }
+
+        uint32_t gap = header.seq - last_seq_;      // Modulo 2^32, so wrap-around is fine
+        if (gap == 0 || gap > 0x80000000u) return 0; // Duplicate or late: already accounted for
+
+        // RFC 3550 interarrival jitter; clock offsets cancel out in the transit difference
+        int64_t d = transit - last_transit_us_;
+        jitter_us_ += (static_cast<double>(std::llabs(d)) - jitter_us_) / 16.0;
+
+        last_seq_ = header.seq;
+        last_transit_us_ = transit;
+        return gap - 1;
+    }
 }
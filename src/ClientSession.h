@@ -2,15 +2,22 @@
 
 #include <string>
 #include <memory>
+#include <atomic>
+#include <vector>
 #include <websocketpp/common/connection_hdl.hpp>
 #include <nlohmann/json.hpp>
 
 #include "BoWWServerDefs.h"
 #include "VADEngine.h"
+#include "BinaryProtocol.h"
+#include "AudioDecoder.h"
 
 namespace boww {
 
     class BoWWServer; 
+    class GroupController;
+
+    using SessionID = uint64_t;
 
     class ClientSession : public std::enable_shared_from_this<ClientSession> {
     public:
@@ -20,30 +27,71 @@ namespace boww {
         void AssignTempID(const std::string& temp_id);
         void SetGUID(const std::string& guid, const std::string& group);
         
-        std::string GetID() const; 
+        const std::string& GetID() const; 
+        const std::string& GetTempID() const { return temp_id_; }
+        SessionID GetSessionID() const { return session_id_; }     // Unique per connection, never reused
         bool IsAuthenticated() const;
-        std::string GetGroup() const;
+        const std::string& GetGroup() const;
+
+        // Group this session streams into, resolved once after hello
+        std::shared_ptr<GroupController> GetGroupController() const { return group_.lock(); }
+        void AttachGroup(const std::shared_ptr<GroupController>& group) { group_ = group; }
 
         // VAD
         void InitVADState(std::shared_ptr<VADSessionState> state);
         std::shared_ptr<VADSessionState> GetVADState();
         void UpdateLastVoiceTime();
         long GetTimeSinceLastVoiceMs(); 
+        std::chrono::steady_clock::time_point GetLastVoiceTime() const { return last_voice_ts_; }
 
         // Comms
         void SendJSON(const nlohmann::json& j);
         void SendStopSignal();
+        void SendConfidenceReceived();
+
+        // Binary framing, negotiated in hello (see BinaryProtocol.h)
+        void SetBinaryProtocol(bool enabled) { binary_ = enabled; }
+        bool UsesBinaryProtocol() const { return binary_; }
+
+        // Sequence/jitter bookkeeping for an incoming binary frame (connection thread only).
+        // Returns how many frames went missing just before this one.
+        uint32_t TrackFrame(const Binary::Header& header, uint64_t arrival_us);
+        uint64_t GetJitterMicros() const { return static_cast<uint64_t>(jitter_us_); }
+
+        // Ingest codec, chosen in hello for the group's rate and channels. Every call builds a
+        // fresh decoder (or none for PCM, or if the codec cannot run at that format), so a
+        // repeated hello never touches a decoder that frames already queued on a strand still use.
+        // Connection thread only, like GetDecoder.
+        void SetCodec(IngestCodec codec, int sample_rate, int channels);
+        IngestCodec GetCodec() const { return codec_; }
+
+        // Captured by each audio frame's strand handler; null for PCM
+        std::shared_ptr<AudioDecoder> GetDecoder() const { return decoder_; }
         websocketpp::connection_hdl GetHandle() const { return connection_handle_; }
 
     private:
         websocketpp::connection_hdl connection_handle_; 
+        SessionID session_id_;
         std::string temp_id_;
         std::string guid_;
         std::string group_name_;
+        std::weak_ptr<GroupController> group_;
+
+        std::atomic<bool> binary_{false};
+        std::atomic<uint32_t> send_seq_{0};
+        bool have_seq_ = false;
+        uint32_t last_seq_ = 0;
+        int64_t last_transit_us_ = 0;
+        double jitter_us_ = 0.0;
+
+        std::atomic<IngestCodec> codec_{IngestCodec::PCM16};
+        std::shared_ptr<AudioDecoder> decoder_;
 
         std::shared_ptr<VADSessionState> vad_state_{nullptr};
         std::chrono::steady_clock::time_point last_voice_ts_;
 
         BoWWServer* server_context_;
+
+        void SendControl(Binary::Type type);
     };
 }
@@ -2,48 +2,119 @@
 #include <iostream>
 #include <fstream>
 #include <yaml-cpp/yaml.h>
-#include <thread>
+#include <algorithm>
+#include <vector>
 #include <chrono>
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 
 namespace boww {
 
+    ConfigManager::~ConfigManager() {
+        StopWatching();
+    }
+
     bool ConfigManager::LoadConfig(const std::string& path) {
         config_path_ = path;
         return ParseYaml();
     }
 
     void ConfigManager::StartWatching() {
-        std::thread([this]() {
-            auto last_write = std::filesystem::last_write_time(config_path_);
-            while (true) {
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-                try {
-                    auto current_write = std::filesystem::last_write_time(config_path_);
-                    if (current_write > last_write) {
-                        std::cout << "[Config] Change detected. Reloading..." << std::endl;
-                        if (ParseYaml()) {
-                            last_write = current_write;
+        if (watcher_.joinable()) return;
+        stop_fd_ = eventfd(0, EFD_CLOEXEC);
+        watcher_ = std::thread(&ConfigManager::WatchLoop, this);
+    }
+
+    void ConfigManager::StopWatching() {
+        if (!watcher_.joinable()) return;
+        uint64_t one = 1;
+        if (write(stop_fd_, &one, sizeof(one)) < 0) {
+            std::cerr << "[Config] Failed to signal watcher: " << std::strerror(errno) << std::endl;
+        }
+        watcher_.join();
+        close(stop_fd_);
+        stop_fd_ = -1;
+    }
+
+    void ConfigManager::WatchLoop() {
+        // Watch the directory, not the file: editors save by writing a temp file and renaming it over
+        std::filesystem::path file(config_path_);
+        std::string dir = file.has_parent_path() ? file.parent_path().string() : ".";
+        std::string name = file.filename().string();
+
+        int in_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (in_fd >= 0 && inotify_add_watch(in_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            close(in_fd);
+            in_fd = -1;
+        }
+        if (in_fd < 0) {
+            std::cerr << "[Config] inotify unavailable (" << std::strerror(errno) << "), polling every 2s" << std::endl;
+        }
+
+        std::filesystem::file_time_type last_write{};
+        try { last_write = std::filesystem::last_write_time(config_path_); } catch (const std::exception&) {}
+
+        alignas(struct inotify_event) char buf[4096];
+        while (true) {
+            struct pollfd fds[2] = {{stop_fd_, POLLIN, 0}, {in_fd, POLLIN, 0}};
+            int n = poll(fds, in_fd >= 0 ? 2 : 1, in_fd >= 0 ? -1 : 2000);
+            if (n < 0 && errno != EINTR) break;
+            if (fds[0].revents & POLLIN) break;
+
+            bool changed = false;
+            if (in_fd >= 0) {
+                if (!(fds[1].revents & POLLIN)) continue;
+                // A save is usually several events; let the burst settle, then reload once
+                do {
+                    ssize_t len;
+                    while ((len = read(in_fd, buf, sizeof(buf))) > 0) {
+                        for (char* p = buf; p < buf + len;) {
+                            auto* ev = reinterpret_cast<struct inotify_event*>(p);
+                            if (ev->len > 0 && name == ev->name) changed = true;
+                            p += sizeof(struct inotify_event) + ev->len;
                         }
                     }
+                } while (poll(&fds[1], 1, 50) > 0);
+            } else {
+                try {
+                    auto current_write = std::filesystem::last_write_time(config_path_);
+                    changed = current_write > last_write;
+                    if (changed) last_write = current_write;
                 } catch (const std::exception& e) {
                     std::cerr << "[Config] Watcher Error: " << e.what() << std::endl;
                 }
             }
-        }).detach();
-    }
 
-    bool ConfigManager::IsGUIDValid(const std::string& guid, ClientInfo& out_info) {
-        if (valid_clients_.count(guid)) {
-            out_info = valid_clients_[guid];
-            return true;
+            if (changed) {
+                std::cout << "[Config] Change detected. Reloading..." << std::endl;
+                ParseYaml();
+            }
         }
-        return false;
+        if (in_fd >= 0) close(in_fd);
+    }
+
+    bool ConfigManager::IsGUIDValid(const std::string& guid, ClientInfo& out_info) const {
+        auto snapshot = GetSnapshot();
+        if (!snapshot) return false;
+        auto it = snapshot->clients.find(guid);
+        if (it == snapshot->clients.end()) return false;
+        out_info = it->second;
+        return true;
     }
 
     bool ConfigManager::ParseYaml() {
+        struct Onboarding { std::string temp_id, guid, group; };
+
         try {
             YAML::Node config = YAML::LoadFile(config_path_);
+            auto previous = GetSnapshot();
+            auto next = std::make_shared<ConfigSnapshot>();
+            std::vector<Onboarding> onboarding;
             
             if (config["groups"]) {
                 for (const auto& node : config["groups"]) {
@@ -54,44 +125,84 @@ namespace boww {
                     if (node["sample_rate"]) gc.sample_rate = node["sample_rate"].as<int>();
                     if (node["channels"]) gc.channels = node["channels"].as<int>();
                     if (node["arbitration_timeout_ms"]) gc.arbitration_timeout_ms = node["arbitration_timeout_ms"].as<int>();
+                    if (node["decisive_score"]) gc.decisive_score = node["decisive_score"].as<float>();
                     if (node["vad_no_voice_ms"]) gc.vad_no_voice_ms = node["vad_no_voice_ms"].as<int>();
+                    if (node["preroll_ms"]) gc.preroll_ms = node["preroll_ms"].as<int>();
+                    if (node["direct_io"]) gc.direct_io = node["direct_io"].as<bool>();
+                    if (node["vad_channel"]) gc.vad_channel = node["vad_channel"].as<int>();
+                    if (node["jitter_min_ms"]) gc.jitter_min_ms = node["jitter_min_ms"].as<int>();
+                    if (node["jitter_max_ms"]) gc.jitter_max_ms = node["jitter_max_ms"].as<int>();
                     // ---------------------------------
 
+                    if (node["channel_policy"]) {
+                        std::string policy = node["channel_policy"].as<std::string>();
+                        if (policy == "downmix") gc.channel_policy = ChannelPolicy::DOWNMIX;
+                        else if (policy == "fixed") gc.channel_policy = ChannelPolicy::FIXED;
+                        else if (policy == "best") gc.channel_policy = ChannelPolicy::BEST;
+                        else std::cerr << "[Config] Group " << gc.name << ": unknown channel_policy '" << policy << "', using best." << std::endl;
+                    }
+                    if (gc.channels < 1) gc.channels = 1;
+                    if (gc.vad_channel < 0 || gc.vad_channel >= gc.channels) {
+                        std::cerr << "[Config] Group " << gc.name << ": vad_channel " << gc.vad_channel << " out of range, using 0." << std::endl;
+                        gc.vad_channel = 0;
+                    }
+                    if (gc.jitter_min_ms < 0) gc.jitter_min_ms = 0;
+                    if (gc.jitter_max_ms < gc.jitter_min_ms) {
+                        std::cerr << "[Config] Group " << gc.name << ": jitter_max_ms below jitter_min_ms, using " << gc.jitter_min_ms << "." << std::endl;
+                        gc.jitter_max_ms = gc.jitter_min_ms;
+                    }
+
                     if (node["output"]) {
                         std::string output = node["output"].as<std::string>();
                         if (output == "file") gc.output_type = OutputType::FILE;
+                        else if (output == "flac") gc.output_type = OutputType::FLAC;
                         else if (output == "alsa") {
                             gc.output_type = OutputType::ALSA;
                             if (node["device"]) gc.output_target = node["device"].as<std::string>();
+                            if (node["mix_gain"]) gc.mix_gain = std::max(0.0f, node["mix_gain"].as<float>());
                         }
                     }
 
-                    if (OnGroupConfigChanged) OnGroupConfigChanged(gc);
-                    groups_[gc.name] = gc;
+                    next->groups[gc.name] = gc;
                 }
             }
 
             if (config["clients"]) {
-                std::map<std::string, ClientInfo> new_clients;
                 for (const auto& node : config["clients"]) {
                     ClientInfo info;
                     info.guid = node["guid"].as<std::string>();
                     info.group_name = node["group"].as<std::string>();
-                    new_clients[info.guid] = info;
+                    next->clients[info.guid] = info;
 
                     if (node["onboard_temp_id"]) {
                         std::string temp_id = node["onboard_temp_id"].as<std::string>();
-                        if (!temp_id.empty() && OnClientOnboarded) {
-                            std::cout << "[Config] Found Onboarding Request for TempID: " << temp_id << std::endl;
-                            OnClientOnboarded(temp_id, info.guid, info.group_name);
-                        }
+                        if (!temp_id.empty()) onboarding.push_back({temp_id, info.guid, info.group_name});
                     }
                 }
-                valid_clients_ = new_clients;
+            } else if (previous) {
+                next->clients = previous->clients;
+            }
+
+            // Publish before notifying, so an onboarded client's hello already finds its GUID
+            std::atomic_store(&snapshot_, std::shared_ptr<const ConfigSnapshot>(next));
+
+            // Only new or edited groups are reported; unchanged ones keep running untouched
+            for (const auto& [name, gc] : next->groups) {
+                bool changed = true;
+                if (previous) {
+                    auto it = previous->groups.find(name);
+                    changed = (it == previous->groups.end()) || !(it->second == gc);
+                }
+                if (changed && OnGroupConfigChanged) OnGroupConfigChanged(gc);
+            }
+
+            for (const auto& req : onboarding) {
+                std::cout << "[Config] Found Onboarding Request for TempID: " << req.temp_id << std::endl;
+                if (OnClientOnboarded) OnClientOnboarded(req.temp_id, req.guid, req.group);
             }
 
-            std::cout << "[Config] Loaded " << groups_.size() << " groups and " 
-                      << valid_clients_.size() << " clients." << std::endl;
+            std::cout << "[Config] Loaded " << next->groups.size() << " groups and " 
+                      << next->clients.size() << " clients." << std::endl;
             return true;
 
         } catch (const YAML::Exception& e) {
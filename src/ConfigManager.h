@@ -1,26 +1,47 @@
 #pragma once
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <atomic>
 #include <functional>
 #include "BoWWServerDefs.h"
 
 namespace boww {
 
+    // One parsed clients.yaml. Never modified after publication.
+    struct ConfigSnapshot {
+        std::map<std::string, GroupConfig> groups;
+        std::unordered_map<std::string, ClientInfo> clients;
+    };
+
     class ConfigManager {
     public:
+        ~ConfigManager();
+
         bool LoadConfig(const std::string& path);
         void StartWatching();
+        void StopWatching();
 
         std::function<void(std::string temp_id, std::string new_guid, std::string group)> OnClientOnboarded;
         std::function<void(GroupConfig new_config)> OnGroupConfigChanged;
 
-        bool IsGUIDValid(const std::string& guid, ClientInfo& out_info);
+        bool IsGUIDValid(const std::string& guid, ClientInfo& out_info) const;
+
+        // Current config; safe from any thread, stays valid for as long as the caller holds it
+        std::shared_ptr<const ConfigSnapshot> GetSnapshot() const { return std::atomic_load(&snapshot_); }
 
     private:
         std::string config_path_;
-        std::map<std::string, GroupConfig> groups_;
-        std::map<std::string, ClientInfo> valid_clients_;
+
+        // Reloads build a new snapshot and swap it in (RCU style); only accessed via atomic_load/atomic_store
+        std::shared_ptr<const ConfigSnapshot> snapshot_;
+
+        std::thread watcher_;
+        int stop_fd_ = -1;
         
         bool ParseYaml();
+        void WatchLoop();
     };
 }
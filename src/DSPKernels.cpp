@@ -0,0 +1,545 @@
+#include "DSPKernels.h"
+
+#if defined(__x86_64__) || defined(__SSE2__)
+    #include <immintrin.h>
+    #define BOWW_DSP_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define BOWW_DSP_NEON 1
+#endif
+
+// GCC contracts a * b + c into FMA across statements on targets that have it (AArch64);
+// kernels documented as unfused opt out so the scalar reference rounds like the SIMD ones
+#if defined(__GNUC__) && !defined(__clang__)
+    #define BOWW_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+    #define BOWW_NO_FP_CONTRACT
+#endif
+
+namespace boww {
+namespace dsp {
+
+    // --- Scalar reference ---
+    namespace scalar {
+
+        uint64_t SumSquares(const int16_t* x, size_t n) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < n; ++i) {
+                sum += static_cast<uint64_t>(static_cast<int32_t>(x[i]) * x[i]);
+            }
+            return sum;
+        }
+
+        void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain) {
+            for (size_t i = 0; i < n; ++i) {
+                float val = in[i] * gain;
+                if (val > 32767.0f) val = 32767.0f;
+                if (val < -32768.0f) val = -32768.0f;
+                out[i] = static_cast<int16_t>(val);
+            }
+        }
+
+        void Int16ToFloat(const int16_t* in, float* out, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<float>(in[i]) / 32768.0f;
+            }
+        }
+
+        float DotProduct(const float* a, const float* b, size_t n) {
+            float sum = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        void Deinterleave(const int16_t* in, size_t frames, int channels, int16_t* const* planes) {
+            for (size_t f = 0; f < frames; ++f) {
+                for (int c = 0; c < channels; ++c) {
+                    planes[c][f] = in[f * channels + c];
+                }
+            }
+        }
+
+        void Downmix(const int16_t* in, size_t frames, int channels, int16_t* out) {
+            for (size_t f = 0; f < frames; ++f) {
+                int32_t sum = 0;
+                for (int c = 0; c < channels; ++c) sum += in[f * channels + c];
+                // Floor division, so power-of-two counts match an arithmetic shift
+                out[f] = static_cast<int16_t>(sum >= 0 ? sum / channels : -((-sum + channels - 1) / channels));
+            }
+        }
+
+        BOWW_NO_FP_CONTRACT
+        void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain) {
+            for (size_t i = 0; i < n; ++i) {
+                float val = static_cast<float>(in[i]) * gain;
+                acc[i] += val;
+            }
+        }
+
+        void SaturateToInt16(const float* in, int16_t* out, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                float val = in[i];
+                if (val > 32767.0f) val = 32767.0f;
+                if (val < -32768.0f) val = -32768.0f;
+                out[i] = static_cast<int16_t>(val);
+            }
+        }
+    }
+
+#if defined(BOWW_DSP_X86)
+
+    // --- SSE2 (baseline on x86-64) ---
+    namespace sse2 {
+
+        uint64_t SumSquares(const int16_t* x, size_t n) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = _mm_setzero_si128();   // 2 x u64
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+                // Pairwise sums of squares; 2 * 32768^2 only fits as unsigned, so zero-extend
+                __m128i sq = _mm_madd_epi16(v, v);
+                acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq, zero));
+                acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq, zero));
+            }
+            uint64_t lanes[2];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+            return lanes[0] + lanes[1] + scalar::SumSquares(x + i, n - i);
+        }
+
+        void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain) {
+            const __m128 g = _mm_set1_ps(gain);
+            const __m128 hi = _mm_set1_ps(32767.0f);
+            const __m128 lo = _mm_set1_ps(-32768.0f);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                __m128i v_lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                __m128i v_hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+                __m128 f_lo = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(v_lo), g), hi), lo);
+                __m128 f_hi = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(v_hi), g), hi), lo);
+                __m128i r = _mm_packs_epi32(_mm_cvttps_epi32(f_lo), _mm_cvttps_epi32(f_hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+            }
+            scalar::ScaleSaturate(in + i, out + i, n - i, gain);
+        }
+
+        void Int16ToFloat(const int16_t* in, float* out, size_t n) {
+            const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);   // Exact power of two
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                __m128i v_lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                __m128i v_hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v_lo), scale));
+                _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(v_hi), scale));
+            }
+            scalar::Int16ToFloat(in + i, out + i, n - i);
+        }
+
+        float DotProduct(const float* a, const float* b, size_t n) {
+            __m128 acc0 = _mm_setzero_ps();
+            __m128 acc1 = _mm_setzero_ps();     // Two chains hide the add latency
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar::DotProduct(a + i, b + i, n - i);
+        }
+
+        // Even/odd int16 lanes of v, sign-extended to int32
+        static inline __m128i EvenLanes(__m128i v) { return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16); }
+        static inline __m128i OddLanes(__m128i v) { return _mm_srai_epi32(v, 16); }
+
+        void Deinterleave(const int16_t* in, size_t frames, int channels, int16_t* const* planes) {
+            size_t f = 0;
+            if (channels == 2) {
+                for (; f + 8 <= frames; f += 8) {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + f * 2));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + f * 2 + 8));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[0] + f), _mm_packs_epi32(EvenLanes(a), EvenLanes(b)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[1] + f), _mm_packs_epi32(OddLanes(a), OddLanes(b)));
+                }
+            } else if (channels == 4) {
+                // Two stereo-style splits: (0,2)/(1,3) pairs first, then each pair apart
+                for (; f + 8 <= frames; f += 8) {
+                    const __m128i* p = reinterpret_cast<const __m128i*>(in + f * 4);
+                    __m128i v0 = _mm_loadu_si128(p), v1 = _mm_loadu_si128(p + 1);
+                    __m128i v2 = _mm_loadu_si128(p + 2), v3 = _mm_loadu_si128(p + 3);
+                    __m128i even_lo = _mm_packs_epi32(EvenLanes(v0), EvenLanes(v1));     // c0 c2 of frames 0-3
+                    __m128i even_hi = _mm_packs_epi32(EvenLanes(v2), EvenLanes(v3));     // c0 c2 of frames 4-7
+                    __m128i odd_lo = _mm_packs_epi32(OddLanes(v0), OddLanes(v1));        // c1 c3
+                    __m128i odd_hi = _mm_packs_epi32(OddLanes(v2), OddLanes(v3));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[0] + f), _mm_packs_epi32(EvenLanes(even_lo), EvenLanes(even_hi)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[2] + f), _mm_packs_epi32(OddLanes(even_lo), OddLanes(even_hi)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[1] + f), _mm_packs_epi32(EvenLanes(odd_lo), EvenLanes(odd_hi)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[3] + f), _mm_packs_epi32(OddLanes(odd_lo), OddLanes(odd_hi)));
+                }
+            }
+            if (f == frames) return;
+            int16_t* rest[8];
+            if (channels > 8) {
+                scalar::Deinterleave(in, frames, channels, planes);     // Rare; redo from the start
+                return;
+            }
+            for (int c = 0; c < channels; ++c) rest[c] = planes[c] + f;
+            scalar::Deinterleave(in + f * channels, frames - f, channels, rest);
+        }
+
+        void Downmix(const int16_t* in, size_t frames, int channels, int16_t* out) {
+            const __m128i ones = _mm_set1_epi16(1);
+            size_t f = 0;
+            if (channels == 2) {
+                for (; f + 8 <= frames; f += 8) {
+                    // madd against ones sums each L/R pair in 32 bits
+                    __m128i a = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + f * 2)), ones);
+                    __m128i b = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + f * 2 + 8)), ones);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + f), _mm_packs_epi32(_mm_srai_epi32(a, 1), _mm_srai_epi32(b, 1)));
+                }
+            } else if (channels == 4) {
+                for (; f + 8 <= frames; f += 8) {
+                    const __m128i* p = reinterpret_cast<const __m128i*>(in + f * 4);
+                    __m128 s0 = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128(p), ones));       // (c0+c1, c2+c3) x 2 frames
+                    __m128 s1 = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128(p + 1), ones));
+                    __m128 s2 = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128(p + 2), ones));
+                    __m128 s3 = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128(p + 3), ones));
+                    __m128i lo = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0))),
+                                               _mm_castps_si128(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1))));
+                    __m128i hi = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(s2, s3, _MM_SHUFFLE(2, 0, 2, 0))),
+                                               _mm_castps_si128(_mm_shuffle_ps(s2, s3, _MM_SHUFFLE(3, 1, 3, 1))));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + f), _mm_packs_epi32(_mm_srai_epi32(lo, 2), _mm_srai_epi32(hi, 2)));
+                }
+            }
+            scalar::Downmix(in + f * channels, frames - f, channels, out + f);
+        }
+
+        void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain) {
+            const __m128 g = _mm_set1_ps(gain);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), g);
+                __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), g);
+                _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), lo));
+                _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), hi));
+            }
+            scalar::MixAccumulate(in + i, acc + i, n - i, gain);
+        }
+
+        void SaturateToInt16(const float* in, int16_t* out, size_t n) {
+            const __m128 hi = _mm_set1_ps(32767.0f);
+            const __m128 lo = _mm_set1_ps(-32768.0f);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i), hi), lo);
+                __m128 b = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(in + i + 4), hi), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+            }
+            scalar::SaturateToInt16(in + i, out + i, n - i);
+        }
+    }
+
+    // --- AVX2 (compiled per-function, selected at runtime) ---
+    // The rest of the build is non-VEX SSE, so each kernel clears the upper register halves
+    // before its SSE tail and return; without that every later SSE op pays a transition stall.
+    namespace avx2 {
+
+        __attribute__((target("avx2")))
+        uint64_t SumSquares(const int16_t* x, size_t n) {
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i acc = _mm256_setzero_si256();   // 4 x u64
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+                __m256i sq = _mm256_madd_epi16(v, v);
+                acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(sq, zero));
+                acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(sq, zero));
+            }
+            uint64_t lanes[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+            _mm256_zeroupper();
+            return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sse2::SumSquares(x + i, n - i);
+        }
+
+        __attribute__((target("avx2")))
+        void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain) {
+            const __m256 g = _mm256_set1_ps(gain);
+            const __m256 hi = _mm256_set1_ps(32767.0f);
+            const __m256 lo = _mm256_set1_ps(-32768.0f);
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+                __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8)));
+                __m256 fa = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(a), g), hi), lo);
+                __m256 fb = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(b), g), hi), lo);
+                // packs works per 128-bit lane; permute restores sample order
+                __m256i r = _mm256_packs_epi32(_mm256_cvttps_epi32(fa), _mm256_cvttps_epi32(fb));
+                r = _mm256_permute4x64_epi64(r, 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+            }
+            _mm256_zeroupper();
+            sse2::ScaleSaturate(in + i, out + i, n - i, gain);
+        }
+
+        __attribute__((target("avx2")))
+        void Int16ToFloat(const int16_t* in, float* out, size_t n) {
+            const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+                _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+            }
+            _mm256_zeroupper();
+            sse2::Int16ToFloat(in + i, out + i, n - i);
+        }
+
+        __attribute__((target("avx2,fma")))
+        float DotProduct(const float* a, const float* b, size_t n) {
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+            }
+            __m256 acc = _mm256_add_ps(acc0, acc1);
+            __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+            float lanes[4];
+            _mm_storeu_ps(lanes, sum);
+            _mm256_zeroupper();
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sse2::DotProduct(a + i, b + i, n - i);
+        }
+
+        __attribute__((target("avx2")))
+        void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain) {
+            const __m256 g = _mm256_set1_ps(gain);
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m256 a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)))), g);
+                __m256 b = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8)))), g);
+                _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), a));
+                _mm256_storeu_ps(acc + i + 8, _mm256_add_ps(_mm256_loadu_ps(acc + i + 8), b));
+            }
+            _mm256_zeroupper();
+            sse2::MixAccumulate(in + i, acc + i, n - i, gain);
+        }
+
+        __attribute__((target("avx2")))
+        void SaturateToInt16(const float* in, int16_t* out, size_t n) {
+            const __m256 hi = _mm256_set1_ps(32767.0f);
+            const __m256 lo = _mm256_set1_ps(-32768.0f);
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m256 a = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i), hi), lo);
+                __m256 b = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(in + i + 8), hi), lo);
+                __m256i r = _mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b));
+                r = _mm256_permute4x64_epi64(r, 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+            }
+            _mm256_zeroupper();
+            sse2::SaturateToInt16(in + i, out + i, n - i);
+        }
+    }
+
+    static bool HasAVX2() {
+        static const bool has = __builtin_cpu_supports("avx2");
+        return has;
+    }
+
+    // Every AVX2 CPU we run on has FMA too, but the float kernel checks rather than assumes
+    static bool HasFMA() {
+        static const bool has = HasAVX2() && __builtin_cpu_supports("fma");
+        return has;
+    }
+
+    uint64_t SumSquares(const int16_t* x, size_t n) {
+        return HasAVX2() ? avx2::SumSquares(x, n) : sse2::SumSquares(x, n);
+    }
+
+    void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain) {
+        if (HasAVX2()) avx2::ScaleSaturate(in, out, n, gain);
+        else sse2::ScaleSaturate(in, out, n, gain);
+    }
+
+    void Int16ToFloat(const int16_t* in, float* out, size_t n) {
+        if (HasAVX2()) avx2::Int16ToFloat(in, out, n);
+        else sse2::Int16ToFloat(in, out, n);
+    }
+
+    float DotProduct(const float* a, const float* b, size_t n) {
+        return HasFMA() ? avx2::DotProduct(a, b, n) : sse2::DotProduct(a, b, n);
+    }
+
+    void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain) {
+        if (HasAVX2()) avx2::MixAccumulate(in, acc, n, gain);
+        else sse2::MixAccumulate(in, acc, n, gain);
+    }
+
+    void SaturateToInt16(const float* in, int16_t* out, size_t n) {
+        if (HasAVX2()) avx2::SaturateToInt16(in, out, n);
+        else sse2::SaturateToInt16(in, out, n);
+    }
+
+    // Memory-bound at these sizes, so SSE2 only
+    void Deinterleave(const int16_t* in, size_t frames, int channels, int16_t* const* planes) {
+        sse2::Deinterleave(in, frames, channels, planes);
+    }
+
+    void Downmix(const int16_t* in, size_t frames, int channels, int16_t* out) {
+        sse2::Downmix(in, frames, channels, out);
+    }
+
+    const char* ActiveISA() {
+        return HasAVX2() ? "avx2" : "sse2";
+    }
+
+#elif defined(BOWW_DSP_NEON)
+
+    // --- NEON (Raspberry Pi) ---
+    uint64_t SumSquares(const int16_t* x, size_t n) {
+        int64x2_t acc = vdupq_n_s64(0);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t v = vld1q_s16(x + i);
+            int32x4_t sq_lo = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+            int32x4_t sq_hi = vmull_s16(vget_high_s16(v), vget_high_s16(v));
+            acc = vpadalq_s32(acc, sq_lo);
+            acc = vpadalq_s32(acc, sq_hi);
+        }
+        uint64_t sum = static_cast<uint64_t>(vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1));
+        return sum + scalar::SumSquares(x + i, n - i);
+    }
+
+    void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain) {
+        const float32x4_t hi = vdupq_n_f32(32767.0f);
+        const float32x4_t lo = vdupq_n_f32(-32768.0f);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t v = vld1q_s16(in + i);
+            float32x4_t f_lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+            float32x4_t f_hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+            f_lo = vmaxq_f32(vminq_f32(vmulq_n_f32(f_lo, gain), hi), lo);
+            f_hi = vmaxq_f32(vminq_f32(vmulq_n_f32(f_hi, gain), hi), lo);
+            // vcvtq_s32_f32 truncates toward zero, like static_cast
+            int16x8_t r = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(f_lo)), vqmovn_s32(vcvtq_s32_f32(f_hi)));
+            vst1q_s16(out + i, r);
+        }
+        scalar::ScaleSaturate(in + i, out + i, n - i, gain);
+    }
+
+    void Int16ToFloat(const int16_t* in, float* out, size_t n) {
+        const float scale = 1.0f / 32768.0f;   // Exact power of two
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t v = vld1q_s16(in + i);
+            vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+            vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+        }
+        scalar::Int16ToFloat(in + i, out + i, n - i);
+    }
+
+    float DotProduct(const float* a, const float* b, size_t n) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        float32x4_t acc = vaddq_f32(acc0, acc1);
+        float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        return vget_lane_f32(vpadd_f32(pair, pair), 0) + scalar::DotProduct(a + i, b + i, n - i);
+    }
+
+    void Deinterleave(const int16_t* in, size_t frames, int channels, int16_t* const* planes) {
+        size_t f = 0;
+        if (channels == 2) {
+            for (; f + 8 <= frames; f += 8) {
+                int16x8x2_t v = vld2q_s16(in + f * 2);
+                vst1q_s16(planes[0] + f, v.val[0]);
+                vst1q_s16(planes[1] + f, v.val[1]);
+            }
+        } else if (channels == 4) {
+            for (; f + 8 <= frames; f += 8) {
+                int16x8x4_t v = vld4q_s16(in + f * 4);
+                for (int c = 0; c < 4; ++c) vst1q_s16(planes[c] + f, v.val[c]);
+            }
+        }
+        if (f == frames) return;
+        if (channels > 8) {
+            scalar::Deinterleave(in, frames, channels, planes);
+            return;
+        }
+        int16_t* rest[8];
+        for (int c = 0; c < channels; ++c) rest[c] = planes[c] + f;
+        scalar::Deinterleave(in + f * channels, frames - f, channels, rest);
+    }
+
+    void Downmix(const int16_t* in, size_t frames, int channels, int16_t* out) {
+        size_t f = 0;
+        if (channels == 2) {
+            for (; f + 8 <= frames; f += 8) {
+                int16x8x2_t v = vld2q_s16(in + f * 2);
+                vst1q_s16(out + f, vhaddq_s16(v.val[0], v.val[1]));    // (a + b) >> 1 without overflow
+            }
+        } else if (channels == 4) {
+            for (; f + 8 <= frames; f += 8) {
+                int16x8x4_t v = vld4q_s16(in + f * 4);
+                int32x4_t lo = vaddq_s32(vaddl_s16(vget_low_s16(v.val[0]), vget_low_s16(v.val[1])),
+                                         vaddl_s16(vget_low_s16(v.val[2]), vget_low_s16(v.val[3])));
+                int32x4_t hi = vaddq_s32(vaddl_s16(vget_high_s16(v.val[0]), vget_high_s16(v.val[1])),
+                                         vaddl_s16(vget_high_s16(v.val[2]), vget_high_s16(v.val[3])));
+                vst1q_s16(out + f, vcombine_s16(vshrn_n_s32(lo, 2), vshrn_n_s32(hi, 2)));
+            }
+        }
+        scalar::Downmix(in + f * channels, frames - f, channels, out + f);
+    }
+
+    void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain) {
+        const float32x4_t g = vdupq_n_f32(gain);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t v = vld1q_s16(in + i);
+            // Separate vmulq + vaddq (never vfmaq) to round like the scalar path
+            float32x4_t lo = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), g);
+            float32x4_t hi = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), g);
+            vst1q_f32(acc + i, vaddq_f32(vld1q_f32(acc + i), lo));
+            vst1q_f32(acc + i + 4, vaddq_f32(vld1q_f32(acc + i + 4), hi));
+        }
+        scalar::MixAccumulate(in + i, acc + i, n - i, gain);
+    }
+
+    void SaturateToInt16(const float* in, int16_t* out, size_t n) {
+        const float32x4_t hi = vdupq_n_f32(32767.0f);
+        const float32x4_t lo = vdupq_n_f32(-32768.0f);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            float32x4_t a = vmaxq_f32(vminq_f32(vld1q_f32(in + i), hi), lo);
+            float32x4_t b = vmaxq_f32(vminq_f32(vld1q_f32(in + i + 4), hi), lo);
+            vst1q_s16(out + i, vcombine_s16(vmovn_s32(vcvtq_s32_f32(a)), vmovn_s32(vcvtq_s32_f32(b))));
+        }
+        scalar::SaturateToInt16(in + i, out + i, n - i);
+    }
+
+    const char* ActiveISA() { return "neon"; }
+
+#else
+
+    uint64_t SumSquares(const int16_t* x, size_t n) { return scalar::SumSquares(x, n); }
+    void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain) { scalar::ScaleSaturate(in, out, n, gain); }
+    void Int16ToFloat(const int16_t* in, float* out, size_t n) { scalar::Int16ToFloat(in, out, n); }
+    float DotProduct(const float* a, const float* b, size_t n) { return scalar::DotProduct(a, b, n); }
+    void Deinterleave(const int16_t* in, size_t frames, int channels, int16_t* const* planes) { scalar::Deinterleave(in, frames, channels, planes); }
+    void Downmix(const int16_t* in, size_t frames, int channels, int16_t* out) { scalar::Downmix(in, frames, channels, out); }
+    void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain) { scalar::MixAccumulate(in, acc, n, gain); }
+    void SaturateToInt16(const float* in, int16_t* out, size_t n) { scalar::SaturateToInt16(in, out, n); }
+    const char* ActiveISA() { return "scalar"; }
+
+#endif
+}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace boww {
+namespace dsp {
+
+    // Hot-path sample kernels shared by the AGC, the VAD input stage and the output path.
+    // Each has a scalar reference and SIMD variants (NEON on ARM, SSE2/AVX2 on x86)
+    // that are bit-exact with it. AVX2 is picked at runtime when the CPU has it.
+
+    // Sum of x[i]^2, exact (64-bit accumulation)
+    uint64_t SumSquares(const int16_t* x, size_t n);
+
+    // out[i] = int16(clamp(in[i] * gain, -32768, 32767)), truncating toward zero.
+    // in == out is allowed (in-place gain).
+    void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain);
+
+    // out[i] = in[i] / 32768.0f
+    void Int16ToFloat(const int16_t* in, float* out, size_t n);
+
+    // Interleaved frames -> one plane per channel: planes[c][f] = in[f * channels + c].
+    // SIMD for 2 and 4 channels, scalar for any other count.
+    void Deinterleave(const int16_t* in, size_t frames, int channels, int16_t* const* planes);
+
+    // out[f] = floor(sum over channels of in[f * channels + c] / channels)
+    void Downmix(const int16_t* in, size_t frames, int channels, int16_t* out);
+
+    // acc[i] += in[i] * gain (multiply, then add: no FMA, so every ISA rounds the same)
+    void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain);
+
+    // out[i] = int16(clamp(in[i], -32768, 32767)), truncating toward zero like ScaleSaturate
+    void SaturateToInt16(const float* in, int16_t* out, size_t n);
+
+    // Sum of a[i] * b[i] (FIR taps against history). The one float reduction here: SIMD
+    // variants add in a different order, so they match scalar to rounding, not bit for bit.
+    float DotProduct(const float* a, const float* b, size_t n);
+
+    // Name of the instruction set the dispatcher selected ("avx2", "sse2", "neon", "scalar")
+    const char* ActiveISA();
+
+    // Plain C++ reference implementations
+    namespace scalar {
+        uint64_t SumSquares(const int16_t* x, size_t n);
+        void ScaleSaturate(const int16_t* in, int16_t* out, size_t n, float gain);
+        void Int16ToFloat(const int16_t* in, float* out, size_t n);
+        float DotProduct(const float* a, const float* b, size_t n);
+        void Deinterleave(const int16_t* in, size_t frames, int channels, int16_t* const* planes);
+        void Downmix(const int16_t* in, size_t frames, int channels, int16_t* out);
+        void MixAccumulate(const int16_t* in, float* acc, size_t n, float gain);
+        void SaturateToInt16(const float* in, int16_t* out, size_t n);
+    }
+}
+}
@@ -1,50 +1,189 @@
 #include "GroupController.h"
+#include "DSPKernels.h"
 #include <iostream>
 #include <vector>
 #include <cmath>
 #include <iomanip>
 #include <algorithm> 
+#include <cstring>
 
 namespace boww {
 
-    GroupController::GroupController(GroupConfig config, VADEngine& vad_engine, bool debug_mode)
-        : config_(config), vad_engine_(vad_engine), audio_router_(config), debug_mode_(debug_mode) 
+    static size_t PreRollSamples(const GroupConfig& config) {
+        return static_cast<size_t>(std::max(0, config.preroll_ms)) * config.sample_rate * config.channels / 1000;
+    }
+
+    GroupController::GroupController(GroupConfig config, VADScheduler& vad_scheduler, websocketpp::lib::asio::io_service& io_service, bool debug_mode)
+        : name_(config.name), config_(config), vad_scheduler_(vad_scheduler), audio_router_(config), debug_mode_(debug_mode), strand_(io_service), timer_(io_service),
+          ingest_buffer_(VAD_CHUNK_SIZE + SLICE_SAMPLES, DropPolicy::DROP_OLDEST),
+          jitter_buffer_(config.sample_rate, config.channels, config.jitter_min_ms, config.jitter_max_ms, SLICE_SAMPLES),
+          channel_selector_(config.channels, config.channel_policy, config.vad_channel),
+          resampler_(config.sample_rate, VAD_SAMPLE_RATE),
+          preroll_pool_(PreRollSamples(config)),
+          preroll_samples_(preroll_pool_.CapacitySamples())
     {
         std::cout << "[Group: " << config.name << "] Initialized." << std::endl;
-        alsa_accumulator_.reserve(JITTER_TARGET * 2);
+        mono_.reserve(channel_selector_.MaxOutput(SliceSamples()));
+        sidechain_.reserve(resampler_.MaxOutput(SLICE_SAMPLES));
+        agc_chunk_.resize(VAD_CHUNK_SIZE);
+        if (!channel_selector_.IsPassthrough()) {
+            std::cout << "[Group: " << config.name << "] Sidechain from " << config.channels << " channels ("
+                      << ChannelPolicyName(config.channel_policy) << ")." << std::endl;
+        }
+        if (!resampler_.IsPassthrough()) {
+            std::cout << "[Group: " << config.name << "] Sidechain resampling " << config.sample_rate << " -> "
+                      << VAD_SAMPLE_RATE << " Hz (" << resampler_.GetTapsPerPhase() << " taps/phase)." << std::endl;
+        }
     }
 
     void GroupController::HandleConfidenceScore(std::shared_ptr<ClientSession> session, float score) {
         std::lock_guard<std::mutex> lock(mutex_);
         if (state_ == GroupState::LOCKED) return;
 
-        candidates_[session->GetID()] = {score, session};
+        ConfidenceEntry& entry = candidates_[session->GetSessionID()];
+        entry.score = score;
+        entry.session = session;
+        if (!entry.preroll) entry.preroll = preroll_pool_.Acquire();
+
+        members_[session->GetSessionID()] = session;     // A client that reports is connected, whatever the hello order
+
         std::cout << "[Group: " << config_.name << "] Candidate: " << session->GetID() << " Score: " << score << std::endl;
 
         if (state_ == GroupState::IDLE) {
             state_ = GroupState::ARBITRATING;
             arbitration_start_time_ = std::chrono::steady_clock::now();
+            ArmTimer(arbitration_start_time_ + std::chrono::milliseconds(config_.arbitration_timeout_ms));
             std::cout << "[Group: " << config_.name << "] Arbitration started." << std::endl;
         }
+        ResolveEarly(score);
     }
 
-    void GroupController::OnTick() {
+    void GroupController::AddMember(const std::shared_ptr<ClientSession>& session) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        members_[session->GetSessionID()] = session;
+    }
+
+    void GroupController::RemoveMember(const std::shared_ptr<ClientSession>& session) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        members_.erase(session->GetSessionID());
+        // A client that left cannot win; it is still referenced elsewhere, so its weak_ptr would lock
+        if (state_ == GroupState::ARBITRATING) {
+            auto it = candidates_.find(session->GetSessionID());
+            if (it != candidates_.end()) {
+                preroll_pool_.Release(std::move(it->second.preroll));
+                candidates_.erase(it);
+            }
+            // The round may have been waiting only on this client
+            ResolveEarly(-1.0f);
+        }
+    }
+
+    // Caller holds mutex_. Ends the round now when waiting longer cannot change the winner:
+    // a decisive score, or a score from every connected member.
+    void GroupController::ResolveEarly(float score) {
+        if (state_ != GroupState::ARBITRATING) return;
+        if (config_.decisive_score > 0.0f && score >= config_.decisive_score) {
+            ResolveArbitration(ArbitrationReason::DECISIVE);
+        } else if (AllMembersReported()) {
+            ResolveArbitration(ArbitrationReason::ALL_REPORTED);
+        }
+    }
+
+    // Caller holds mutex_
+    bool GroupController::AllMembersReported() {
+        for (auto it = members_.begin(); it != members_.end();) {
+            if (it->second.expired()) {
+                it = members_.erase(it);
+                continue;
+            }
+            if (!candidates_.count(it->first)) return false;
+            ++it;
+        }
+        return !members_.empty();
+    }
+
+    void GroupController::UpdateConfig(const GroupConfig& config) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (state_ == GroupState::IDLE) {
+            ApplyConfig(config);
+            std::cout << "[Group: " << config_.name << "] Config applied." << std::endl;
+            return;
+        }
+
+        // Mid-session: take the new timeouts now and move the pending deadline to match
+        config_.arbitration_timeout_ms = config.arbitration_timeout_ms;
+        config_.vad_no_voice_ms = config.vad_no_voice_ms;
+        config_.decisive_score = config.decisive_score;
+        if (state_ == GroupState::ARBITRATING) {
+            ArmTimer(arbitration_start_time_ + std::chrono::milliseconds(config_.arbitration_timeout_ms));
+        } else if (active_streamer_) {
+            ArmTimer(active_streamer_->GetLastVoiceTime() + std::chrono::milliseconds(config_.vad_no_voice_ms + 1));
+        }
+        pending_config_ = config;
+        std::cout << "[Group: " << config_.name << "] Config update deferred until the group is idle." << std::endl;
+    }
+
+    void GroupController::ApplyConfig(const GroupConfig& config) {
+        config_ = config;
+        audio_router_.Reconfigure(config_);
+        if (config_.channels != channel_selector_.GetChannels() || config_.channel_policy != channel_selector_.GetPolicy() ||
+            config_.vad_channel != channel_selector_.GetVadChannel()) {
+            channel_selector_ = ChannelSelector(config_.channels, config_.channel_policy, config_.vad_channel);
+            mono_.reserve(channel_selector_.MaxOutput(SliceSamples()));
+        }
+        if (config_.sample_rate != resampler_.GetInRate()) {
+            resampler_ = Resampler(config_.sample_rate, VAD_SAMPLE_RATE);
+            sidechain_.reserve(resampler_.MaxOutput(SLICE_SAMPLES));
+        }
+        jitter_buffer_ = JitterBuffer(config_.sample_rate, config_.channels, config_.jitter_min_ms, config_.jitter_max_ms, SLICE_SAMPLES);
+        if (PreRollSamples(config_) != preroll_pool_.CapacitySamples()) {
+            preroll_pool_ = PreRollPool(PreRollSamples(config_));
+            preroll_samples_ = preroll_pool_.CapacitySamples();
+        }
+    }
+
+    // Caller holds mutex_, which also serializes every operation on timer_
+    void GroupController::ArmTimer(std::chrono::steady_clock::time_point deadline) {
+        timer_.expires_at(deadline);
+        std::weak_ptr<GroupController> weak = weak_from_this();
+        timer_.async_wait(strand_.wrap([weak, deadline](const auto& ec) {
+            if (ec == websocketpp::lib::asio::error::operation_aborted) return;
+            if (auto self = weak.lock()) self->OnTimer(deadline);
+        }));
+    }
+
+    void GroupController::OnTimer(std::chrono::steady_clock::time_point deadline) {
         std::lock_guard<std::mutex> lock(mutex_);
         auto now = std::chrono::steady_clock::now();
 
+        auto late = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(now - deadline).count());
+        metrics::Add(metrics_.timer_wakeups, 1);
+        metrics_.timer_lateness.Observe(static_cast<uint64_t>(late));
+        if (debug_mode_) {
+            std::cout << "[Group: " << config_.name << "] Timer fired " << late << "us after deadline" << std::endl;
+        }
+
+        // A handler can still be queued after a re-arm or reset, so always re-check the state
         if (state_ == GroupState::ARBITRATING) {
-            long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - arbitration_start_time_).count();
-            if (elapsed >= config_.arbitration_timeout_ms) ResolveArbitration();
+            auto resolve_at = arbitration_start_time_ + std::chrono::milliseconds(config_.arbitration_timeout_ms);
+            if (now >= resolve_at) ResolveArbitration(ArbitrationReason::TIMEOUT);
+            else ArmTimer(resolve_at);
         }
         else if (state_ == GroupState::LOCKED) {
             if (!active_streamer_) { ResetGroup(); return; }
 
-            long silence_duration = active_streamer_->GetTimeSinceLastVoiceMs();
-            if (silence_duration > config_.vad_no_voice_ms) {
+            // Voice keeps pushing the deadline out; we only wake once per window to notice
+            auto window = std::chrono::milliseconds(config_.vad_no_voice_ms);
+            auto last_voice = active_streamer_->GetLastVoiceTime();
+            if (now - last_voice <= window) {
+                ArmTimer(last_voice + window + std::chrono::milliseconds(1));
+            } else {
+                long silence_duration = active_streamer_->GetTimeSinceLastVoiceMs();
                 std::cout << "[Group: " << config_.name << "] VAD Timeout (" << silence_duration << "ms). Stopping." << std::endl;
                 
                 active_streamer_->SendStopSignal();
-                for (auto const& [guid, candidate] : candidates_) {
+                for (auto const& [id, candidate] : candidates_) {
                     if (auto s = candidate.session.lock()) {
                          if (s != active_streamer_) s->SendStopSignal();
                     }
@@ -54,7 +193,7 @@ namespace boww {
         }
     }
 
-    void GroupController::ResolveArbitration() {
+    void GroupController::ResolveArbitration(ArbitrationReason reason) {
         float best_score = -1.0f;
         std::shared_ptr<ClientSession> winner = nullptr;
 
@@ -65,21 +204,49 @@ namespace boww {
                     winner = s;
                 }
                 ++it;
-            } else { it = candidates_.erase(it); }
+            } else {
+                preroll_pool_.Release(std::move(it->second.preroll));
+                it = candidates_.erase(it);
+            }
         }
 
         if (winner) {
-            std::cout << "[Group: " << config_.name << "] Winner: " << winner->GetID() << std::endl;
             state_ = GroupState::LOCKED;
             active_streamer_ = winner;
+
+            locked_at_ = std::chrono::steady_clock::now();
+            first_write_pending_ = true;
+            auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(locked_at_ - arbitration_start_time_).count();
+            metrics_.arbitration_duration[static_cast<size_t>(reason)].Observe(duration_us);
+            std::cout << "[Group: " << config_.name << "] Winner: " << winner->GetID() << " (" << ArbitrationReasonName(reason)
+                      << ", " << duration_us / 1000.0 << "ms)" << std::endl;
             
-            ingest_buffer_.clear();
-            alsa_accumulator_.clear();
+            ingest_buffer_.Clear();
+            jitter_buffer_.Reset();
+            channel_selector_.Reset();
+            resampler_.Reset();
 
-            winner->InitVADState(vad_engine_.CreateSessionState());
+            winner->InitVADState(vad_scheduler_.GetEngine().CreateSessionState());
+            ArmTimer(winner->GetLastVoiceTime() + std::chrono::milliseconds(config_.vad_no_voice_ms + 1));
+            vad_scheduler_.AddStream();
             audio_router_.OpenStream(winner->GetID());
 
-            for (auto const& [guid, candidate] : candidates_) {
+            // Splice the winner's pre-roll in front of the live stream; any frame that
+            // arrives from now on waits on mutex_, so ordering is preserved
+            for (auto& [id, candidate] : candidates_) {
+                if (!candidate.preroll || candidate.session.lock() != winner) continue;
+                PreRollBuffer& preroll = *candidate.preroll;
+                if (preroll.Size() > preroll_samples_) preroll.Consume(preroll.Size() - preroll_samples_);
+                auto spans = preroll.GetReadSpans();
+                if (debug_mode_) {
+                    std::cout << "[Group: " << config_.name << "] Pre-roll: " << spans.size() << " samples" << std::endl;
+                }
+                ProcessSamples(spans.first, spans.first_size);
+                ProcessSamples(spans.second, spans.second_size);
+            }
+            ReleasePreRolls();
+
+            for (auto const& [id, candidate] : candidates_) {
                 if (auto s = candidate.session.lock()) {
                     if (s != winner) s->SendStopSignal();
                 }
@@ -90,64 +257,149 @@ namespace boww {
     }
 
     void GroupController::ResetGroup() {
+        if (state_ == GroupState::LOCKED) {
+            // The tail of the command is still buffered; it goes out before the stream closes
+            FlushOutput();
+            vad_scheduler_.RemoveStream();
+        }
         state_ = GroupState::IDLE;
+        timer_.cancel();
+        ReleasePreRolls();
         candidates_.clear();
         active_streamer_ = nullptr;
         audio_router_.CloseStream();
-        ingest_buffer_.clear();
-        alsa_accumulator_.clear();
+        ingest_buffer_.Clear();
+        jitter_buffer_.Reset();
+        first_write_pending_ = false;
+        metrics_.ingest_depth.store(0, std::memory_order_relaxed);
+        metrics_.accumulator_fill.store(0, std::memory_order_relaxed);
+
+        if (pending_config_) {
+            ApplyConfig(*pending_config_);
+            pending_config_.reset();
+            std::cout << "[Group: " << config_.name << "] Deferred config applied." << std::endl;
+        }
+    }
+
+    void GroupController::ReleasePreRolls() {
+        for (auto& [id, candidate] : candidates_) {
+            preroll_pool_.Release(std::move(candidate.preroll));
+        }
     }
 
-    void GroupController::HandleAudioStream(std::shared_ptr<ClientSession> session, const std::vector<int16_t>& pcm_data) {
+    void GroupController::HandleAudioStream(const std::shared_ptr<ClientSession>& session, PcmView pcm_data) {
         std::lock_guard<std::mutex> lock(mutex_);
+        metrics::Add(metrics_.frames_received, 1);
+        metrics::Add(metrics_.bytes_received, pcm_data.size * sizeof(int16_t));
 
-        if (state_ != GroupState::LOCKED || session != active_streamer_) return;
+        if (state_ == GroupState::ARBITRATING) {
+            // Keep the start of the command while the floor is being decided
+            auto it = candidates_.find(session->GetSessionID());
+            if (it != candidates_.end() && it->second.preroll) {
+                it->second.preroll->Write(pcm_data.data, pcm_data.size);
+            } else {
+                metrics::Add(metrics_.frames_dropped, 1);
+            }
+            return;
+        }
 
-        // --- STAGE 1: INGEST (RAW) ---
-        for (int16_t sample : pcm_data) {
-            ingest_buffer_.push_back(sample);
+        if (state_ != GroupState::LOCKED || session != active_streamer_) {
+            metrics::Add(metrics_.frames_dropped, 1);
+            return;
+        }
+        if (jitter_buffer_.OnArrival(pcm_data.size, std::chrono::steady_clock::now())) {
+            metrics::Add(metrics_.jitter_underruns, 1);
         }
+        metrics_.jitter_target_us.store(jitter_buffer_.TargetMicros(), std::memory_order_relaxed);
+        ProcessSamples(pcm_data.data, pcm_data.size);
+    }
 
-        // --- STAGE 2: PROCESS ---
-        static std::vector<int16_t> raw_chunk(VAD_CHUNK_SIZE);
-        static std::vector<int16_t> agc_chunk(VAD_CHUNK_SIZE);
-        static int debug_counter = 0; 
+    void GroupController::ProcessSamples(const int16_t* src, size_t count) {
+        const size_t slice = SliceSamples();
+        while (count > 0) {
+            // Bounded slices keep every scratch buffer at its reserved size, whatever the frame size
+            size_t n = std::min(count, slice);
 
-        while (ingest_buffer_.size() >= VAD_CHUNK_SIZE) {
-            // 2a. Split Path
-            for (size_t i = 0; i < VAD_CHUNK_SIZE; ++i) {
-                int16_t val = ingest_buffer_.front();
-                raw_chunk[i] = val; // Path A: Output
-                agc_chunk[i] = val; // Path B: Detection
-                ingest_buffer_.pop_front();
-            }
+            // --- PATH A: OUTPUT (native rate, attenuated raw, through the jitter buffer) ---
+            dsp::ScaleSaturate(src, jitter_buffer_.Append(n), n, 0.4f);
+            if (jitter_buffer_.Ready()) FlushOutput();
 
-            // 2b. Path B: AGC + VAD
-            agc_.Process(agc_chunk);
-            float voice_prob = vad_engine_.Process(active_streamer_->GetVADState(), agc_chunk);
-            
-            if (debug_mode_ && ++debug_counter % 10 == 0) {
-               int16_t debug_amp = 0;
-               for(auto s : agc_chunk) if(std::abs(s) > debug_amp) debug_amp = std::abs(s);
-               std::cout << "[VAD] Prob: " << std::fixed << std::setprecision(2) << voice_prob 
-                         << " | Sidechain Amp: " << debug_amp 
-                         << " | Gain: " << std::setprecision(1) << agc_.GetCurrentGain() << "x" << std::endl;
+            // --- PATH B: DETECTION (mono -> resampled to VAD rate -> AGC -> VAD) ---
+            const int16_t* side = src;
+            size_t side_count = n;
+            if (!channel_selector_.IsPassthrough()) {
+                mono_.clear();
+                channel_selector_.Process(side, side_count, mono_);
+                side = mono_.data();
+                side_count = mono_.size();
+                metrics_.vad_channel.store(channel_selector_.GetActiveChannel(), std::memory_order_relaxed);
             }
-
-            if (voice_prob > 0.5f) {
-                active_streamer_->UpdateLastVoiceTime();
+            if (!resampler_.IsPassthrough()) {
+                sidechain_.clear();
+                resampler_.Process(side, side_count, sidechain_);
+                side = sidechain_.data();
+                side_count = sidechain_.size();
             }
 
-            // 2c. Path A: Output (Attenuated Raw)
-            for (int16_t raw_sample : raw_chunk) {
-                alsa_accumulator_.push_back(static_cast<int16_t>(raw_sample * 0.4f));
+            while (side_count > 0) {
+                size_t m = std::min(side_count, ingest_buffer_.Free());
+                ingest_buffer_.Write(side, m);
+                side += m;
+                side_count -= m;
+
+                while (ingest_buffer_.Size() >= VAD_CHUNK_SIZE) {
+                    // AGC + VAD (batched across groups, result via OnVADResult)
+                    ingest_buffer_.Read(agc_chunk_.data(), VAD_CHUNK_SIZE);
+                    agc_.Process(agc_chunk_);
+                    metrics_.agc_gain.store(agc_.GetCurrentGain(), std::memory_order_relaxed);
+                    metrics::Add(metrics_.chunks_processed, 1);
+                    if (!vad_scheduler_.Submit(shared_from_this(), active_streamer_, active_streamer_->GetVADState(), agc_chunk_.data())) {
+                        metrics::Add(metrics_.vad_chunks_shed, 1);
+                    }
+
+                    if (debug_mode_ && ++debug_counter_ % 10 == 0) {
+                       int16_t debug_amp = 0;
+                       for(auto s : agc_chunk_) if(std::abs(s) > debug_amp) debug_amp = std::abs(s);
+                       std::cout << "[VAD] Prob: " << std::fixed << std::setprecision(2) << last_voice_prob_ 
+                                 << " | Sidechain Amp: " << debug_amp 
+                                 << " | Gain: " << std::setprecision(1) << agc_.GetCurrentGain() << "x" << std::endl;
+                    }
+                }
             }
+
+            src += n;
+            count -= n;
         }
 
-        // --- STAGE 3: WRITE ---
-        if (alsa_accumulator_.size() >= JITTER_TARGET) {
-            audio_router_.WriteChunk(alsa_accumulator_);
-            alsa_accumulator_.clear();
+        metrics_.ingest_depth.store(ingest_buffer_.Size(), std::memory_order_relaxed);
+        metrics_.accumulator_fill.store(jitter_buffer_.Size(), std::memory_order_relaxed);
+    }
+
+    void GroupController::FlushOutput() {
+        size_t whole = jitter_buffer_.WholeSamples();
+        if (whole == 0) return;
+
+        auto now = std::chrono::steady_clock::now();
+        metrics_.jitter_delay.Observe(jitter_buffer_.DelayMicros(now));
+        audio_router_.WriteChunk(jitter_buffer_.Data(), whole);
+        jitter_buffer_.Consume(whole, now);
+
+        if (first_write_pending_) {
+            first_write_pending_ = false;
+            metrics_.lock_to_first_write.Observe(std::chrono::duration_cast<std::chrono::microseconds>(now - locked_at_).count());
+        }
+    }
+
+    void GroupController::OnVADResult(const std::shared_ptr<ClientSession>& session, float voice_prob, uint64_t latency_us) {
+        metrics_.vad_latency.Observe(latency_us);
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Late result for a stream that already ended or lost the lock
+        if (state_ != GroupState::LOCKED || session != active_streamer_) return;
+
+        last_voice_prob_ = voice_prob;
+        if (voice_prob > 0.5f) {
+            active_streamer_->UpdateLastVoiceTime();
         }
     }
 }
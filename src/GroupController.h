@@ -1,17 +1,25 @@
 #pragma once
 #include <map>
 #include <vector>
-#include <deque>
 #include <string>
 #include <memory>
 #include <mutex>
 #include <chrono>
+#include <optional>
+#include <websocketpp/common/asio.hpp>
 
 #include "BoWWServerDefs.h"
 #include "VADEngine.h"
+#include "VADScheduler.h"
 #include "ClientSession.h"
 #include "AudioOutputRouter.h"
 #include "SimpleAGC.h"
+#include "RingBuffer.h"
+#include "PreRollPool.h"
+#include "Metrics.h"
+#include "Resampler.h"
+#include "ChannelSelector.h"
+#include "JitterBuffer.h"
 
 namespace boww {
 
@@ -24,37 +32,97 @@ namespace boww {
     struct ConfidenceEntry {
         float score;
         std::weak_ptr<ClientSession> session;
+        std::unique_ptr<PreRollBuffer> preroll;     // Audio streamed while arbitrating
     };
 
-    class GroupController {
+    class GroupController : public std::enable_shared_from_this<GroupController> {
     public:
-        GroupController(GroupConfig config, VADEngine& vad_engine, bool debug_mode = false);
+        using Strand = websocketpp::lib::asio::io_service::strand;
+        using Timer = websocketpp::lib::asio::steady_timer;
+
+        GroupController(GroupConfig config, VADScheduler& vad_scheduler, websocketpp::lib::asio::io_service& io_service, bool debug_mode = false);
         
+        // All audio for this group is posted here so one room never runs concurrently with itself
+        Strand& GetStrand() { return strand_; }
+
         void HandleConfidenceScore(std::shared_ptr<ClientSession> session, float score);
-        void OnTick();
-        void HandleAudioStream(std::shared_ptr<ClientSession> session, const std::vector<int16_t>& pcm_data);
+
+        // Connected, authenticated clients of this group: the set arbitration expects scores from
+        void AddMember(const std::shared_ptr<ClientSession>& session);
+        void RemoveMember(const std::shared_ptr<ClientSession>& session);
+
+        // Live config update from a reload. Timeouts apply at once; audio format and
+        // output settings wait until the group is idle.
+        void UpdateConfig(const GroupConfig& config);
+        void HandleAudioStream(const std::shared_ptr<ClientSession>& session, PcmView pcm_data);
+
+        // Completion from the VAD scheduler thread for a chunk submitted by HandleAudioStream
+        void OnVADResult(const std::shared_ptr<ClientSession>& session, float voice_prob, uint64_t latency_us);
+
+        // Network stats from binary-framed clients, recorded on the receiving thread
+        void RecordNetwork(uint32_t frames_lost, uint64_t jitter_us) {
+            if (frames_lost) metrics::Add(metrics_.frames_lost, frames_lost);
+            metrics_.network_jitter.Observe(jitter_us);
+        }
+        void RecordDecodeError() { metrics::Add(metrics_.decode_errors, 1); }
+
+        // Safe from any thread: the name keys the group and never changes, unlike config_
+        const std::string& GetName() const { return name_; }
+        GroupConfig GetConfig() { std::lock_guard<std::mutex> lock(mutex_); return config_; }
+        GroupState GetState() { std::lock_guard<std::mutex> lock(mutex_); return state_; }
+        const GroupMetrics& GetMetrics() const { return metrics_; }
+        const FileWriterStats& GetWriterStats() const { return audio_router_.GetWriterStats(); }
+        const PlaybackStats& GetPlaybackStats() const { return audio_router_.GetPlaybackStats(); }
 
     private:
+        const std::string name_;
         GroupConfig config_;
-        VADEngine& vad_engine_;
+        VADScheduler& vad_scheduler_;
         AudioOutputRouter audio_router_;
         SimpleAGC agc_; 
         bool debug_mode_;
+        Strand strand_;
+        Timer timer_;                           // Armed only while ARBITRATING or LOCKED
         
         std::mutex mutex_;
         GroupState state_ = GroupState::IDLE;
         
-        std::map<std::string, ConfidenceEntry> candidates_;
+        std::map<SessionID, ConfidenceEntry> candidates_;
+        std::map<SessionID, std::weak_ptr<ClientSession>> members_;
         std::shared_ptr<ClientSession> active_streamer_;
         std::chrono::steady_clock::time_point arbitration_start_time_;
 
-        std::deque<int16_t> ingest_buffer_;      
-        std::vector<int16_t> alsa_accumulator_;  
-        
-        const size_t VAD_CHUNK_SIZE = 512;       
-        const size_t JITTER_TARGET = 2048;       
+        static constexpr size_t SLICE_SAMPLES = 2048;       // Largest piece ProcessSamples handles at once
+
+        RingBuffer<int16_t> ingest_buffer_;      // Sidechain at VAD rate; holds < VAD_CHUNK_SIZE between frames
+        JitterBuffer jitter_buffer_;             // Output path at the group's native rate
+        ChannelSelector channel_selector_;       // Interleaved frames -> mono, sidechain only
+        Resampler resampler_;                    // Native rate -> VAD_SAMPLE_RATE, sidechain only
+        std::vector<int16_t> mono_;              // Per-group scratch (groups may run in parallel)
+        std::vector<int16_t> sidechain_;
+        std::vector<int16_t> agc_chunk_;
+        int debug_counter_ = 0;
+        float last_voice_prob_ = 0.0f;
+
+        PreRollPool preroll_pool_;
+        size_t preroll_samples_;
+
+        std::optional<GroupConfig> pending_config_;
+
+        GroupMetrics metrics_;
+        std::chrono::steady_clock::time_point locked_at_;
+        bool first_write_pending_ = false;
 
-        void ResolveArbitration();
+        void ArmTimer(std::chrono::steady_clock::time_point deadline);
+        void OnTimer(std::chrono::steady_clock::time_point deadline);
+        void ResolveArbitration(ArbitrationReason reason);
+        void ResolveEarly(float score);
+        bool AllMembersReported();
         void ResetGroup();
+        void ReleasePreRolls();
+        void ApplyConfig(const GroupConfig& config);
+        void ProcessSamples(const int16_t* src, size_t count);
+        void FlushOutput();
+        size_t SliceSamples() const { return (SLICE_SAMPLES / config_.channels) * config_.channels; }
     };
 }
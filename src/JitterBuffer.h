@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace boww {
+
+    // Output-path jitter buffer for the active streamer. At the start of a stream, and after
+    // an underrun, audio is held until the playout target is buffered; from then on each
+    // frame is released to the router as it arrives, so the cushion built up front is what
+    // absorbs late frames and the target is the latency it costs.
+    //
+    // The target follows the stream: every network frame updates an RFC 3550 jitter
+    // estimate (arrival spacing against the audio duration of the previous frame) and a
+    // decaying peak of the same deviation, which catches the bursts Wi-Fi produces that
+    // the smoothed estimate averages away. Target = one frame + max(4 * jitter, peak),
+    // clamped to [min_ms, max_ms].
+    //
+    // Underruns are found with a virtual playout clock: released audio is assumed to play
+    // in real time from the first release, so a frame arriving after everything released
+    // so far has played out means the consumer went dry. The buffer then rebuffers to the
+    // (by now larger) target.
+    // Not thread-safe: used under the owning group's mutex.
+    class JitterBuffer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr double kJitterMultiplier = 4.0;
+        static constexpr double kPeakHoldUs = 2e6;      // Time constant for a burst to be forgotten
+
+        // max_append: the largest single Append, so a full buffer never reallocates
+        JitterBuffer(int sample_rate, int channels, int min_ms, int max_ms, size_t max_append = 0)
+            : sample_rate_(std::max(1, sample_rate)), channels_(static_cast<size_t>(std::max(1, channels))),
+              min_samples_(MsToSamples(std::max(0, min_ms))), max_samples_(std::max(min_samples_, MsToSamples(std::max(0, max_ms))))
+        {
+            buffer_.reserve(max_samples_ + max_append);
+            Reset();
+        }
+
+        // New stream: forget the estimate and the playout clock, drop anything buffered
+        void Reset() {
+            buffer_.clear();
+            have_arrival_ = false;
+            playing_ = false;
+            jitter_us_ = 0.0;
+            peak_us_ = 0.0;
+            target_samples_ = min_samples_;
+        }
+
+        // One network frame of count interleaved samples arrived (before it is appended).
+        // Returns true if playout had run dry waiting for it.
+        bool OnArrival(size_t count, Clock::time_point now) {
+            double frame_us = SamplesToMicros(count);
+            if (have_arrival_) {
+                double spacing = std::chrono::duration<double, std::micro>(now - last_arrival_).count();
+                double d = std::abs(spacing - last_frame_us_);
+                jitter_us_ += (d - jitter_us_) / 16.0;
+                peak_us_ = std::max(d, peak_us_ * std::exp(-spacing / kPeakHoldUs));
+            }
+            have_arrival_ = true;
+            last_arrival_ = now;
+            last_frame_us_ = frame_us;
+
+            double target_us = frame_us + std::max(kJitterMultiplier * jitter_us_, peak_us_);
+            size_t target = static_cast<size_t>(target_us * sample_rate_ / 1e6) * channels_;
+            target_samples_ = std::clamp(target, min_samples_, max_samples_);
+
+            bool underrun = playing_ && now > playout_end_;
+            if (underrun) playing_ = false;
+            return underrun;
+        }
+
+        // Room for count more samples at the tail; the caller fills it
+        int16_t* Append(size_t count) {
+            if (buffer_.empty()) oldest_ = Clock::now();
+            size_t pos = buffer_.size();
+            buffer_.resize(pos + count);
+            return buffer_.data() + pos;
+        }
+
+        // Prebuffering: the target is in. Playing: anything is.
+        bool Ready() const { return playing_ ? !buffer_.empty() : buffer_.size() >= target_samples_; }
+        const int16_t* Data() const { return buffer_.data(); }
+        size_t Size() const { return buffer_.size(); }
+
+        // A split frame from a pre-roll span waits for its other half
+        size_t WholeSamples() const { return buffer_.size() - buffer_.size() % channels_; }
+
+        // How long the oldest buffered sample has waited
+        uint64_t DelayMicros(Clock::time_point now) const {
+            if (buffer_.empty()) return 0;
+            return static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(now - oldest_).count()));
+        }
+
+        // Drops the count samples just handed downstream and advances the playout clock
+        void Consume(size_t count, Clock::time_point now) {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + count);
+            if (!buffer_.empty()) oldest_ = now;
+
+            if (!playing_) {
+                playing_ = true;
+                playout_end_ = now;
+            }
+            playout_end_ += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(SamplesToMicros(count)));
+        }
+
+        bool IsPlaying() const { return playing_; }
+
+        size_t TargetSamples() const { return target_samples_; }
+        uint64_t TargetMicros() const { return static_cast<uint64_t>(SamplesToMicros(target_samples_)); }
+        uint64_t JitterMicros() const { return static_cast<uint64_t>(jitter_us_); }
+
+    private:
+        int sample_rate_;
+        size_t channels_;
+        size_t min_samples_;
+        size_t max_samples_;
+        size_t target_samples_ = 0;
+
+        std::vector<int16_t> buffer_;
+        Clock::time_point oldest_;          // Arrival of the first sample in buffer_
+
+        bool have_arrival_ = false;
+        Clock::time_point last_arrival_;
+        double last_frame_us_ = 0.0;
+        double jitter_us_ = 0.0;
+        double peak_us_ = 0.0;
+
+        bool playing_ = false;
+        Clock::time_point playout_end_;     // When the audio released so far has played out
+
+        size_t MsToSamples(int ms) const { return static_cast<size_t>(ms) * sample_rate_ / 1000 * channels_; }
+        double SamplesToMicros(size_t samples) const { return static_cast<double>(samples / channels_) * 1e6 / sample_rate_; }
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace boww {
+
+    // Fixed log2-bucket histogram for the Prometheus endpoint. Observe() is two relaxed
+    // atomic adds and a short scan, so it is safe (and cheap) from any thread.
+    class Histogram {
+    public:
+        static constexpr size_t kBuckets = 16;
+
+        // Bucket bounds are first_bound_us * 2^i; values are recorded in microseconds
+        explicit Histogram(uint64_t first_bound_us) {
+            for (size_t i = 0; i < kBuckets; ++i) bounds_[i] = first_bound_us << i;
+        }
+
+        void Observe(uint64_t value_us) {
+            size_t i = 0;
+            while (i < kBuckets && value_us > bounds_[i]) ++i;
+            counts_[i].fetch_add(1, std::memory_order_relaxed);
+            sum_us_.fetch_add(value_us, std::memory_order_relaxed);
+        }
+
+        uint64_t SumMicros() const { return sum_us_.load(std::memory_order_relaxed); }
+
+        uint64_t Count() const {
+            uint64_t n = 0;
+            for (const auto& c : counts_) n += c.load(std::memory_order_relaxed);
+            return n;
+        }
+
+        // Exposition in seconds, cumulative buckets as Prometheus expects
+        void Write(std::ostream& os, const std::string& name, const std::string& labels) const {
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                cumulative += counts_[i].load(std::memory_order_relaxed);
+                os << name << "_bucket{" << labels << ",le=\"" << bounds_[i] / 1e6 << "\"} " << cumulative << '\n';
+            }
+            cumulative += counts_[kBuckets].load(std::memory_order_relaxed);
+            os << name << "_bucket{" << labels << ",le=\"+Inf\"} " << cumulative << '\n';
+            os << name << "_sum{" << labels << "} " << sum_us_.load(std::memory_order_relaxed) / 1e6 << '\n';
+            os << name << "_count{" << labels << "} " << cumulative << '\n';
+        }
+
+    private:
+        std::array<uint64_t, kBuckets> bounds_;
+        std::array<std::atomic<uint64_t>, kBuckets + 1> counts_{};     // Last slot is +Inf
+        std::atomic<uint64_t> sum_us_{0};
+    };
+
+    namespace metrics {
+        inline void Header(std::ostream& os, const char* name, const char* type, const char* help) {
+            os << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+        }
+
+        inline void Add(std::atomic<uint64_t>& counter, uint64_t n) {
+            counter.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    // Why an arbitration round ended
+    enum class ArbitrationReason {
+        TIMEOUT,        // arbitration_timeout_ms ran out
+        ALL_REPORTED,   // Every connected member of the group had sent a score
+        DECISIVE        // A score reached decisive_score
+    };
+
+    inline const char* ArbitrationReasonName(ArbitrationReason reason) {
+        switch (reason) {
+            case ArbitrationReason::ALL_REPORTED: return "all_reported";
+            case ArbitrationReason::DECISIVE: return "decisive";
+            default: return "timeout";
+        }
+    }
+
+    // Per-group instrumentation. Written on the group strand (and the VAD worker for
+    // latency), read by the /metrics handler; no locks on either side.
+    struct GroupMetrics {
+        std::atomic<uint64_t> frames_received{0};
+        std::atomic<uint64_t> bytes_received{0};
+        std::atomic<uint64_t> frames_dropped{0};      // Sender had no claim on the group
+        std::atomic<uint64_t> chunks_processed{0};
+        std::atomic<uint64_t> ingest_depth{0};        // Samples waiting for a full VAD chunk
+        std::atomic<uint64_t> accumulator_fill{0};    // Samples held in the output jitter buffer
+        std::atomic<uint64_t> jitter_target_us{0};    // Current playout target of that buffer
+        std::atomic<uint64_t> jitter_underruns{0};    // Playout ran dry before the next frame arrived
+        std::atomic<float> agc_gain{1.0f};
+        std::atomic<uint64_t> frames_lost{0};         // Sequence gaps from binary-framed clients
+        std::atomic<uint64_t> decode_errors{0};       // Compressed frames that failed to decode
+        std::atomic<uint64_t> vad_chunks_shed{0};     // Dropped because the VAD queue was backed up
+        std::atomic<int> vad_channel{0};              // Channel feeding VAD; -1 when downmixed
+        std::atomic<uint64_t> timer_wakeups{0};       // Deadline timer firings (none while idle)
+
+        Histogram vad_latency{100};                   // Submit -> result, from 100us
+        // First score -> decision by ArbitrationReason, from 100us (early decisions land well under 1ms)
+        Histogram arbitration_duration[3]{Histogram{100}, Histogram{100}, Histogram{100}};
+        Histogram lock_to_first_write{1000};          // Decision -> first output write, from 1ms
+        Histogram network_jitter{100};                // Per-frame RFC 3550 jitter estimate, from 100us
+        Histogram timer_lateness{10};                 // Timer deadline -> handler running, from 10us
+        Histogram jitter_delay{1000};                 // Oldest sample's wait in the jitter buffer at release, from 1ms
+    };
+}
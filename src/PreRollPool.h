@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "RingBuffer.h"
+
+namespace boww {
+
+    using PreRollBuffer = RingBuffer<int16_t>;
+
+    // Recycles fixed-size pre-roll rings, so once warm an arbitration round allocates nothing.
+    // Not thread-safe: used under the owning group's mutex.
+    class PreRollPool {
+    public:
+        explicit PreRollPool(size_t capacity_samples = 0) : capacity_(capacity_samples) {}
+
+        // Returns nullptr when pre-roll is disabled (capacity 0)
+        std::unique_ptr<PreRollBuffer> Acquire() {
+            if (capacity_ == 0) return nullptr;
+            if (free_.empty()) {
+                return std::make_unique<PreRollBuffer>(capacity_, DropPolicy::DROP_OLDEST);
+            }
+            auto buf = std::move(free_.back());
+            free_.pop_back();
+            return buf;
+        }
+
+        void Release(std::unique_ptr<PreRollBuffer> buf) {
+            if (!buf) return;
+            buf->Clear();
+            buf->ResetStats();
+            free_.push_back(std::move(buf));
+        }
+
+        size_t CapacitySamples() const { return capacity_; }
+
+    private:
+        size_t capacity_;
+        std::vector<std::unique_ptr<PreRollBuffer>> free_;
+    };
+}
@@ -0,0 +1,232 @@
+#include "Replay.h"
+#include "ConfigManager.h"
+#include "VADEngine.h"
+#include "SimpleAGC.h"
+#include "AudioOutputRouter.h"
+#include "DSPKernels.h"
+#include "Resampler.h"
+#include "ChannelSelector.h"
+#include "WavFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace boww {
+
+    namespace {
+
+        constexpr size_t OUTPUT_BLOCK = 2048;           // GroupController's slice size; offline, so no jitter buffer
+        constexpr size_t WRITER_HEADROOM = 256 * 1024;  // Back off before the writer ring can overflow
+
+        struct ReplayResult {
+            std::string file;
+            bool ok = false;
+            std::string error;
+            double audio_s = 0.0;
+            double processed_s = 0.0;       // Audio actually run through, up to the endpoint
+            double wall_s = 0.0;
+            double speech_start_s = -1.0;   // First chunk above the voice threshold
+            double last_voice_s = -1.0;
+            double endpoint_s = -1.0;       // When the server would have sent stop (-1 = never)
+            uint64_t dropped_samples = 0;
+        };
+
+        // Mirrors GroupController's LOCKED path, with time taken from the sample position:
+        // raw -> (channel select -> resample -> AGC -> VAD) sidechain, raw * 0.4 -> output at the file's own rate and channels,
+        // stop after vad_no_voice_ms of silence.
+        ReplayResult ReplayFile(const std::string& path, GroupConfig config, VADEngine& engine, std::ostream& timeline) {
+            ReplayResult r;
+            r.file = path;
+
+            std::vector<int16_t> samples;
+            int sample_rate = 0, channels = 0;
+            if (!LoadWav(path, samples, sample_rate, channels, r.error)) return r;
+            r.audio_s = static_cast<double>(samples.size()) / (static_cast<double>(sample_rate) * channels);
+
+            auto start = std::chrono::steady_clock::now();
+
+            config.sample_rate = sample_rate;       // Recorded at native rate and channels, like a live group
+            config.channels = channels;
+            const size_t block = (OUTPUT_BLOCK / channels) * channels;
+            AudioOutputRouter router(config);
+            router.OpenStream("replay-" + std::filesystem::path(path).stem().string());
+
+            SimpleAGC agc;
+            ChannelSelector selector(channels, config.channel_policy, config.vad_channel);
+            Resampler resampler(sample_rate, VAD_SAMPLE_RATE);
+            std::vector<int16_t> mono;
+            mono.reserve(selector.MaxOutput(block));
+            auto vad_state = engine.CreateSessionState();
+            std::vector<int16_t> sidechain;
+            sidechain.reserve(resampler.MaxOutput(OUTPUT_BLOCK) + VAD_CHUNK_SIZE);
+            std::vector<int16_t> agc_chunk(VAD_CHUNK_SIZE);
+            std::vector<int16_t> output(block);
+
+            const double chunk_s = static_cast<double>(VAD_CHUNK_SIZE) / VAD_SAMPLE_RATE;
+            const double window_s = config.vad_no_voice_ms / 1000.0;
+            double last_voice = 0.0;    // The server starts the silence clock at lock time
+            size_t chunks = 0;
+
+            timeline << "time_s,prob,agc_gain\n" << std::fixed << std::setprecision(3);
+
+            for (size_t pos = 0; pos < samples.size() && r.endpoint_s < 0; pos += block) {
+                const int16_t* raw = samples.data() + pos;
+                size_t n = std::min(block, samples.size() - pos);
+
+                output.resize(n);
+                dsp::ScaleSaturate(raw, output.data(), n, 0.4f);
+                while (router.GetWriterStats().queued_samples.load() > WRITER_HEADROOM) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                router.WriteChunk(output);
+
+                mono.clear();
+                selector.Process(raw, n, mono);
+                resampler.Process(mono.data(), mono.size(), sidechain);
+                size_t used = 0;
+                for (; used + VAD_CHUNK_SIZE <= sidechain.size(); used += VAD_CHUNK_SIZE) {
+                    double t = static_cast<double>(chunks++) * chunk_s;
+
+                    std::memcpy(agc_chunk.data(), sidechain.data() + used, VAD_CHUNK_SIZE * sizeof(int16_t));
+                    agc.Process(agc_chunk);
+                    float prob = engine.Process(vad_state, PcmView(agc_chunk));
+                    timeline << t << ',' << prob << ',' << agc.GetCurrentGain() << '\n';
+
+                    if (prob > 0.5f) {
+                        if (r.speech_start_s < 0) r.speech_start_s = t;
+                        r.last_voice_s = t;
+                        last_voice = t + chunk_s;
+                    }
+
+                    r.processed_s = t + chunk_s;
+                    if (r.processed_s - last_voice > window_s) {
+                        r.endpoint_s = t + chunk_s;
+                        break;
+                    }
+                }
+                sidechain.erase(sidechain.begin(), sidechain.begin() + used);
+            }
+
+            router.CloseStream();
+
+            r.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            r.dropped_samples = router.GetWriterStats().dropped_samples.load();
+            r.ok = true;
+            return r;
+        }
+
+        std::vector<std::string> CollectFiles(const std::string& path) {
+            std::vector<std::string> files;
+            std::error_code ec;
+            if (std::filesystem::is_directory(path, ec)) {
+                for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+                    if (entry.is_regular_file() && entry.path().extension() == ".wav") files.push_back(entry.path().string());
+                }
+                std::sort(files.begin(), files.end());
+            } else if (std::filesystem::exists(path, ec)) {
+                files.push_back(path);
+            }
+            return files;
+        }
+    }
+
+    int RunReplay(const ServerOptions& options) {
+        auto files = CollectFiles(options.replay_path);
+        if (files.empty()) {
+            std::cerr << "[Replay] No .wav files at " << options.replay_path << std::endl;
+            return 1;
+        }
+
+        // Group settings come from clients.yaml so tuning there carries over to live use
+        GroupConfig config;
+        config.name = options.replay_group.empty() ? "replay" : options.replay_group;
+        ConfigManager config_manager;
+        if (!options.replay_group.empty()) {
+            if (!config_manager.LoadConfig("../clients.yaml")) return 1;
+            auto snapshot = config_manager.GetSnapshot();
+            auto it = snapshot->groups.find(options.replay_group);
+            if (it == snapshot->groups.end()) {
+                std::cerr << "[Replay] Group not found in clients.yaml: " << options.replay_group << std::endl;
+                return 1;
+            }
+            config = it->second;
+        }
+        if (config.output_type == OutputType::ALSA) config.output_type = OutputType::FILE;
+
+        int jobs = options.replay_jobs > 0 ? options.replay_jobs : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        jobs = std::min<int>(jobs, static_cast<int>(files.size()));
+
+        std::filesystem::create_directories("replay");
+        std::cout << "[Replay] " << files.size() << " files, " << jobs << " workers, group '" << config.name
+                  << "' (vad_no_voice_ms " << config.vad_no_voice_ms << ")" << std::endl;
+
+        std::atomic<size_t> next{0};
+        std::mutex print_mutex;
+        std::vector<ReplayResult> results(files.size());
+        bool model_ok = true;
+        auto start = std::chrono::steady_clock::now();
+
+        // One engine (ORT session, single intra-op thread) per worker; files are pulled from a shared index
+        auto worker = [&]() {
+            VADEngine engine(options.debug_mode);
+            if (!engine.Initialize("../models/silero_vad.onnx")) {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                model_ok = false;
+                return;
+            }
+            for (size_t i = next++; i < files.size(); i = next++) {
+                std::string stem = std::filesystem::path(files[i]).stem().string();
+                std::ofstream timeline("replay/" + stem + ".vad.csv");
+                results[i] = ReplayFile(files[i], config, engine, timeline);
+
+                const ReplayResult& r = results[i];
+                std::lock_guard<std::mutex> lock(print_mutex);
+                if (!r.ok) {
+                    std::cout << "[Replay] " << r.file << ": skipped (" << r.error << ")" << std::endl;
+                    continue;
+                }
+                std::cout << "[Replay] " << r.file << std::fixed << std::setprecision(2)
+                          << " | " << r.audio_s << "s audio"
+                          << " | speech " << r.speech_start_s << "-" << r.last_voice_s << "s"
+                          << " | stop " << (r.endpoint_s < 0 ? std::string("none") : std::to_string(r.endpoint_s) + "s")
+                          << " | RTF " << std::setprecision(4) << (r.processed_s > 0 ? r.wall_s / r.processed_s : 0.0);
+                if (r.dropped_samples) std::cout << " | DROPPED " << r.dropped_samples << " samples";
+                std::cout << std::endl;
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int i = 0; i < jobs; ++i) pool.emplace_back(worker);
+        for (auto& t : pool) t.join();
+
+        if (!model_ok) {
+            std::cerr << "[Replay] VAD model load failed." << std::endl;
+            return 1;
+        }
+
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double audio = 0.0;
+        size_t done = 0;
+        for (const auto& r : results) {
+            if (!r.ok) continue;
+            audio += r.processed_s;
+            done++;
+        }
+        std::cout << "[Replay] Done: " << done << "/" << files.size() << " files, " << std::fixed << std::setprecision(1)
+                  << audio << "s audio in " << wall << "s wall (" << (wall > 0 ? audio / wall : 0.0)
+                  << "x realtime, RTF " << std::setprecision(4) << (audio > 0 ? wall / audio : 0.0) << ")."
+                  << " Timelines in replay/." << std::endl;
+        return done == files.size() ? 0 : 1;
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "BoWWServerDefs.h"
+
+namespace boww {
+
+    // Offline mode (--replay): runs WAV files through the group pipeline
+    // (AGC -> VAD -> output router) as fast as the CPU allows, files in parallel.
+    // Writes a per-file VAD timeline to replay/<name>.vad.csv and prints the
+    // endpoint decision and realtime factor. Returns the process exit code.
+    int RunReplay(const ServerOptions& options);
+}
@@ -0,0 +1,98 @@
+#include "Resampler.h"
+#include "DSPKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace boww {
+
+    static constexpr double kZeroCrossings = 16.0;     // Sinc lobes per side of the prototype
+    static constexpr double kRolloff = 0.85;           // Cutoff as a fraction of the lower Nyquist
+    static constexpr double kKaiserBeta = 8.0;         // About 80 dB stopband
+
+    // Zeroth-order modified Bessel function of the first kind (series), for the Kaiser window
+    static double BesselI0(double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12) break;
+        }
+        return sum;
+    }
+
+    Resampler::Resampler(int in_rate, int out_rate) : in_rate_(in_rate), out_rate_(out_rate) {
+        if (in_rate <= 0 || out_rate <= 0) return;     // Misconfigured: pass through rather than divide by zero
+        size_t g = std::gcd(static_cast<size_t>(in_rate), static_cast<size_t>(out_rate));
+        up_ = static_cast<size_t>(out_rate) / g;
+        down_ = static_cast<size_t>(in_rate) / g;
+        if (IsPassthrough()) return;
+
+        // Prototype low-pass at the upsampled rate, cut below the lower of the two Nyquists
+        const double cutoff = kRolloff * 0.5 / static_cast<double>(std::max(up_, down_));   // Cycles per sample
+        const double half_length = kZeroCrossings / (2.0 * cutoff);
+        taps_ = static_cast<size_t>(std::ceil(2.0 * half_length / static_cast<double>(up_)));
+        taps_ = (taps_ + 7) & ~static_cast<size_t>(7);
+
+        const size_t length = taps_ * up_;
+        const double center = (static_cast<double>(length) - 1.0) / 2.0;
+        const double norm = BesselI0(kKaiserBeta);
+        std::vector<double> proto(length);
+        double sum = 0.0;
+        for (size_t n = 0; n < length; ++n) {
+            double x = static_cast<double>(n) - center;
+            double sinc = x == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+            double r = x / (center + 1.0);
+            double window = BesselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+            proto[n] = sinc * window;
+            sum += proto[n];
+        }
+
+        // Unity DC gain per output sample: the taps of one phase sum to ~1 (zero-stuffing gain of up_)
+        bank_.resize(length);
+        for (size_t p = 0; p < up_; ++p) {
+            for (size_t k = 0; k < taps_; ++k) {
+                bank_[p * taps_ + (taps_ - 1 - k)] = static_cast<float>(proto[p + k * up_] * static_cast<double>(up_) / sum);
+            }
+        }
+        Reset();
+    }
+
+    void Resampler::Reset() {
+        if (IsPassthrough()) return;
+        history_.assign(taps_ - 1, 0.0f);
+        history_.reserve(taps_ + 4096);
+        next_input_ = taps_ - 1;
+        phase_ = 0;
+    }
+
+    void Resampler::Process(const int16_t* in, size_t count, std::vector<int16_t>& out) {
+        if (IsPassthrough()) {
+            out.insert(out.end(), in, in + count);
+            return;
+        }
+
+        size_t base = history_.size();
+        history_.resize(base + count);
+        dsp::Int16ToFloat(in, history_.data() + base, count);
+
+        // Output n sits at upsampled position n * down_: input sample (n * down_) / up_, phase (n * down_) % up_
+        while (next_input_ < history_.size()) {
+            float y = dsp::DotProduct(bank_.data() + phase_ * taps_, history_.data() + next_input_ + 1 - taps_, taps_);
+            float s = std::nearbyint(y * 32768.0f);
+            out.push_back(static_cast<int16_t>(std::clamp(s, -32768.0f, 32767.0f)));
+            phase_ += down_;
+            next_input_ += phase_ / up_;
+            phase_ %= up_;
+        }
+
+        // Keep just the context the next output needs
+        size_t drop = std::min(next_input_ + 1 - taps_, history_.size());
+        if (drop > 0) {
+            std::memmove(history_.data(), history_.data() + drop, (history_.size() - drop) * sizeof(float));
+            history_.resize(history_.size() - drop);
+            next_input_ -= drop;
+        }
+    }
+}
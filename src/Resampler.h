@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace boww {
+
+    // Streaming rational-ratio resampler for the detection sidechain (e.g. 48k or 44.1k -> 16k).
+    // Polyphase windowed-sinc: in/out reduce to up/down, and each output sample is one
+    // dot product of a phase's taps against the input history (dsp::DotProduct).
+    // Mono only; equal rates pass straight through. State carries across Process() calls,
+    // so frames of any size give the same output as one long buffer.
+    class Resampler {
+    public:
+        Resampler(int in_rate, int out_rate);
+
+        int GetInRate() const { return in_rate_; }
+        int GetOutRate() const { return out_rate_; }
+        bool IsPassthrough() const { return up_ == down_; }
+        size_t GetTapsPerPhase() const { return taps_; }
+
+        // Appends the output for count new input samples to out
+        void Process(const int16_t* in, size_t count, std::vector<int16_t>& out);
+
+        // Upper bound on the output for count input samples
+        size_t MaxOutput(size_t count) const { return count * up_ / down_ + 2; }
+
+        // Forget the history (new stream)
+        void Reset();
+
+    private:
+        int in_rate_;
+        int out_rate_;
+        size_t up_ = 1;
+        size_t down_ = 1;
+        size_t taps_ = 0;               // Per phase, a multiple of 8 for the SIMD kernel
+
+        std::vector<float> bank_;       // [up_][taps_], each phase reversed to run forward over history_
+        std::vector<float> history_;    // taps_ - 1 samples of context, then unconsumed input
+        size_t next_input_ = 0;         // history_ index of the newest sample the next output uses
+        size_t phase_ = 0;
+    };
+}
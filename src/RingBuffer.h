@@ -0,0 +1,239 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <atomic>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+
+namespace boww {
+
+    enum class DropPolicy {
+        DROP_OLDEST,    // Overwrite the oldest data (keep the most recent audio)
+        DROP_NEWEST     // Reject what does not fit (keep what is already buffered)
+    };
+
+    inline size_t NextPowerOfTwo(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // Fixed-capacity ring buffer for trivially copyable samples.
+    // Capacity is rounded up to a power of two so wrapping is a mask, and storage is
+    // one 64-byte aligned block so bulk transfers are at most two memcpy calls.
+    // Not thread-safe: the owner serializes access (group strand / mutex).
+    template <typename T>
+    class RingBuffer {
+        static_assert(std::is_trivially_copyable<T>::value, "RingBuffer requires trivially copyable T");
+
+    public:
+        static constexpr size_t kAlignment = 64;
+
+        // Readable region as (up to) two contiguous segments
+        struct ReadSpans {
+            const T* first = nullptr;
+            size_t first_size = 0;
+            const T* second = nullptr;
+            size_t second_size = 0;
+            size_t size() const { return first_size + second_size; }
+        };
+
+        RingBuffer(size_t min_capacity = 0, DropPolicy policy = DropPolicy::DROP_OLDEST)
+            : policy_(policy)
+        {
+            if (min_capacity > 0) Allocate(min_capacity);
+        }
+
+        // (Re)allocates storage and empties the buffer. Not for the hot path.
+        void Allocate(size_t min_capacity) {
+            capacity_ = NextPowerOfTwo(std::max<size_t>(min_capacity, 1));
+            mask_ = capacity_ - 1;
+            buffer_.reset(static_cast<T*>(::operator new(capacity_ * sizeof(T), std::align_val_t(kAlignment))));
+            Clear();
+            ResetStats();
+        }
+
+        // Appends up to n elements. Overflow is resolved by the drop policy.
+        // Returns the number of input elements that ended up in the buffer.
+        size_t Write(const T* src, size_t n) {
+            if (n == 0 || capacity_ == 0) return 0;
+
+            size_t accepted = n;
+            if (policy_ == DropPolicy::DROP_OLDEST) {
+                if (n > capacity_) {
+                    // Only the newest `capacity_` inputs can survive
+                    dropped_ += n - capacity_;
+                    src += n - capacity_;
+                    n = capacity_;
+                    accepted = n;
+                }
+                size_t free = Free();
+                if (n > free) {
+                    dropped_ += n - free;
+                    tail_ += n - free;
+                }
+            } else {
+                size_t free = Free();
+                if (n > free) {
+                    dropped_ += n - free;
+                    n = free;
+                    accepted = n;
+                }
+            }
+
+            size_t pos = head_ & mask_;
+            size_t first = std::min(n, capacity_ - pos);
+            std::memcpy(buffer_.get() + pos, src, first * sizeof(T));
+            if (n > first) {
+                std::memcpy(buffer_.get(), src + first, (n - first) * sizeof(T));
+            }
+            head_ += n;
+
+            high_water_ = std::max(high_water_, Size());
+            return accepted;
+        }
+
+        // Copies up to n elements into dst and consumes them. Returns the count read.
+        size_t Read(T* dst, size_t n) {
+            n = Peek(dst, n);
+            tail_ += n;
+            return n;
+        }
+
+        // Copies up to n elements into dst without consuming them.
+        size_t Peek(T* dst, size_t n) const {
+            ReadSpans spans = GetReadSpans(n);
+            if (spans.first_size) {
+                std::memcpy(dst, spans.first, spans.first_size * sizeof(T));
+            }
+            if (spans.second_size) {
+                std::memcpy(dst + spans.first_size, spans.second, spans.second_size * sizeof(T));
+            }
+            return spans.size();
+        }
+
+        // Zero-copy view over up to max_items readable elements (pair with Consume)
+        ReadSpans GetReadSpans(size_t max_items = static_cast<size_t>(-1)) const {
+            ReadSpans spans;
+            size_t n = std::min(max_items, Size());
+            if (n == 0) return spans;
+
+            size_t pos = tail_ & mask_;
+            spans.first = buffer_.get() + pos;
+            spans.first_size = std::min(n, capacity_ - pos);
+            if (n > spans.first_size) {
+                spans.second = buffer_.get();
+                spans.second_size = n - spans.first_size;
+            }
+            return spans;
+        }
+
+        void Consume(size_t n) { tail_ += std::min(n, Size()); }
+        void Clear() { head_ = tail_ = 0; }
+
+        size_t Size() const { return head_ - tail_; }
+        size_t Free() const { return capacity_ - Size(); }
+        size_t Capacity() const { return capacity_; }
+        bool Empty() const { return head_ == tail_; }
+
+        // Diagnostics: peak fill level and elements lost to the drop policy
+        size_t HighWater() const { return high_water_; }
+        size_t Dropped() const { return dropped_; }
+        void ResetStats() { high_water_ = Size(); dropped_ = 0; }
+
+    private:
+        struct AlignedDelete {
+            void operator()(T* p) const { ::operator delete(p, std::align_val_t(kAlignment)); }
+        };
+
+        std::unique_ptr<T, AlignedDelete> buffer_;
+        DropPolicy policy_;
+        size_t capacity_ = 0;
+        size_t mask_ = 0;
+        size_t head_ = 0;   // Total elements written (monotonic)
+        size_t tail_ = 0;   // Total elements consumed (monotonic)
+        size_t high_water_ = 0;
+        size_t dropped_ = 0;
+    };
+
+    // Lock-free single-producer / single-consumer variant for handing audio between
+    // exactly two threads (e.g. a group strand and a writer thread). Never overwrites:
+    // Write() takes what fits and the caller decides what to do with the rest.
+    template <typename T>
+    class SPSCRingBuffer {
+        static_assert(std::is_trivially_copyable<T>::value, "SPSCRingBuffer requires trivially copyable T");
+
+    public:
+        static constexpr size_t kAlignment = 64;
+
+        explicit SPSCRingBuffer(size_t min_capacity)
+            : capacity_(NextPowerOfTwo(std::max<size_t>(min_capacity, 1))), mask_(capacity_ - 1),
+              buffer_(static_cast<T*>(::operator new(capacity_ * sizeof(T), std::align_val_t(kAlignment))))
+        {}
+
+        // Producer side. Returns the number of elements written (may be < n when full).
+        size_t Write(const T* src, size_t n) {
+            size_t head = head_.load(std::memory_order_relaxed);
+            size_t tail = tail_.load(std::memory_order_acquire);
+            n = std::min(n, capacity_ - (head - tail));
+            if (n == 0) return 0;
+
+            size_t pos = head & mask_;
+            size_t first = std::min(n, capacity_ - pos);
+            std::memcpy(buffer_.get() + pos, src, first * sizeof(T));
+            if (n > first) std::memcpy(buffer_.get(), src + first, (n - first) * sizeof(T));
+
+            head_.store(head + n, std::memory_order_release);
+            return n;
+        }
+
+        // Consumer side. Returns the number of elements read.
+        size_t Read(T* dst, size_t n) {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            size_t head = head_.load(std::memory_order_acquire);
+            n = std::min(n, head - tail);
+            if (n == 0) return 0;
+
+            size_t pos = tail & mask_;
+            size_t first = std::min(n, capacity_ - pos);
+            std::memcpy(dst, buffer_.get() + pos, first * sizeof(T));
+            if (n > first) std::memcpy(dst + first, buffer_.get(), (n - first) * sizeof(T));
+
+            tail_.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        // Consumer side: drop up to n elements without copying them
+        size_t Discard(size_t n) {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            size_t head = head_.load(std::memory_order_acquire);
+            n = std::min(n, head - tail);
+            tail_.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        // Snapshot values; exact only when called from the side that owns the other index
+        size_t Size() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+        size_t Free() const { return capacity_ - Size(); }
+        size_t Capacity() const { return capacity_; }
+
+        // Monotonic element counters (stream positions)
+        size_t TotalWritten() const { return head_.load(std::memory_order_acquire); }
+        size_t TotalRead() const { return tail_.load(std::memory_order_acquire); }
+
+    private:
+        struct AlignedDelete {
+            void operator()(T* p) const { ::operator delete(p, std::align_val_t(kAlignment)); }
+        };
+
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<T, AlignedDelete> buffer_;
+
+        // Separate cache lines so producer and consumer do not false-share
+        alignas(64) std::atomic<size_t> head_{0};
+        alignas(64) std::atomic<size_t> tail_{0};
+    };
+}
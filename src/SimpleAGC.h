@@ -3,6 +3,7 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include "DSPKernels.h"
 
 namespace boww {
 
@@ -15,10 +16,7 @@ namespace boww {
         void Process(std::vector<int16_t>& buffer) {
             if (buffer.empty()) return;
 
-            long long sum_squares = 0;
-            for (int16_t sample : buffer) {
-                sum_squares += sample * sample;
-            }
+            uint64_t sum_squares = dsp::SumSquares(buffer.data(), buffer.size());
             float rms = std::sqrt(sum_squares / buffer.size());
 
             // Noise Gate: If signal is floor noise, relax gain to unity
@@ -38,15 +36,8 @@ namespace boww {
                 current_gain_ = (1.0f - alpha) * current_gain_ + alpha * needed_gain;
             }
 
-            // Apply Gain
-            for (size_t i = 0; i < buffer.size(); ++i) {
-                float val = buffer[i] * current_gain_;
-                
-                if (val > 32767.0f) val = 32767.0f;
-                if (val < -32768.0f) val = -32768.0f;
-                
-                buffer[i] = static_cast<int16_t>(val);
-            }
+            // Apply Gain (saturating)
+            dsp::ScaleSaturate(buffer.data(), buffer.data(), buffer.size(), current_gain_);
         }
         
         float GetCurrentGain() const { return current_gain_; }
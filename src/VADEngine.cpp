@@ -1,6 +1,8 @@
 #include "VADEngine.h"
+#include "DSPKernels.h"
 #include <iostream>
 #include <vector>
+#include <cstring>
 
 namespace boww {
 
@@ -15,6 +17,8 @@ namespace boww {
     bool VADEngine::Initialize(const std::string& model_path) {
         try {
             Ort::SessionOptions session_options;
+            // Parallelism comes from VADScheduler's pinned workers calling Run concurrently
+            // (thread-safe); extra intra-op threads would only fight them for cores
             session_options.SetIntraOpNumThreads(1);
             session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
 
@@ -26,66 +30,141 @@ namespace boww {
         }
     }
 
+    // Tensor names of the Silero V5 graph
+    static const char* INPUT_NAMES[] = {"input", "state", "sr"};
+    static const char* OUTPUT_NAMES[] = {"output", "stateN"};
+
+    void VADBatch::Reserve(size_t max_batch) {
+        states.reserve(max_batch);
+        input.resize(max_batch * VAD_CHUNK_SIZE);
+        state.resize(max_batch * VAD_STATE_SIZE);
+        state_out.resize(max_batch * VAD_STATE_SIZE);
+        probs.resize(max_batch);
+        tensors.clear();
+        tensors.resize(max_batch + 1);
+    }
+
+    void VADBatch::Clear() {
+        states.clear();
+    }
+
+    void VADBatch::Add(VADSessionState* s, const float* chunk) {
+        std::memcpy(&input[states.size() * VAD_CHUNK_SIZE], chunk, VAD_CHUNK_SIZE * sizeof(float));
+        states.push_back(s);
+    }
+
     std::shared_ptr<VADSessionState> VADEngine::CreateSessionState() {
         auto s = std::make_shared<VADSessionState>();
-        // Initialize State: 2 * 1 * 128 (Silero V5)
-        s->state.resize(256, 0.0f);
-        // Initialize SR: 16000
-        s->sr.push_back(16000);
-        return s;
-    }
+        // Initialize State: 2 * 1 * 128 (Silero V5), both halves of the ping-pong
+        s->state[0].resize(VAD_STATE_SIZE, 0.0f);
+        s->state[1].resize(VAD_STATE_SIZE, 0.0f);
+        s->sr.push_back(VAD_SAMPLE_RATE);
+        s->input.resize(VAD_CHUNK_SIZE, 0.0f);
 
-    float VADEngine::Process(std::shared_ptr<VADSessionState> state_ptr, const std::vector<int16_t>& pcm_data) {
-        if (!session_ || !state_ptr) return 0.0f;
+        if (!session_) return s;
 
-        // 1. Prepare Input (Normalize Int16 -> Float32)
-        // Silero expects flat float array
-        size_t input_len = pcm_data.size();
-        std::vector<float> input_tensor(input_len);
-        for (size_t i = 0; i < input_len; ++i) {
-            input_tensor[i] = static_cast<float>(pcm_data[i]) / 32768.0f;
-        }
+        // Shapes are copied into the tensors at creation
+        int64_t input_shape[] = {1, static_cast<int64_t>(VAD_CHUNK_SIZE)};
+        int64_t state_shape[] = {2, 1, static_cast<int64_t>(VAD_STATE_DIM)};
+        int64_t sr_shape[] = {1};
+        int64_t prob_shape[] = {1, 1};
+
+        try {
+            s->tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, s->input.data(), s->input.size(), input_shape, 2));
+            s->tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, s->state[0].data(), VAD_STATE_SIZE, state_shape, 3));
+            s->tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, s->state[1].data(), VAD_STATE_SIZE, state_shape, 3));
+            s->tensors.push_back(Ort::Value::CreateTensor<int64_t>(memory_info_, s->sr.data(), s->sr.size(), sr_shape, 1));
+            s->tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, &s->prob, 1, prob_shape, 2));
 
-        // 2. Define Shapes
-        // Input: [1, N]
-        std::vector<int64_t> input_shape = {1, static_cast<int64_t>(input_len)};
-        // State: [2, 1, 128]
-        std::vector<int64_t> state_shape = {2, 1, 128};
-        // SR: [1]
-        std::vector<int64_t> sr_shape = {1};
+            Ort::Value& input = s->tensors[0];
+            Ort::Value& sr = s->tensors[3];
+            Ort::Value& prob = s->tensors[4];
+            for (int parity = 0; parity < 2; ++parity) {
+                auto binding = std::make_unique<Ort::IoBinding>(*session_);
+                binding->BindInput(INPUT_NAMES[0], input);
+                binding->BindInput(INPUT_NAMES[1], s->tensors[1 + parity]);
+                binding->BindInput(INPUT_NAMES[2], sr);
+                binding->BindOutput(OUTPUT_NAMES[0], prob);
+                binding->BindOutput(OUTPUT_NAMES[1], s->tensors[2 - parity]);
+                s->binding[parity] = std::move(binding);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[VAD] Binding Error: " << e.what() << std::endl;
+        }
+        return s;
+    }
 
-        // 3. Create ORT Tensors
-        std::vector<Ort::Value> input_tensors;
-        input_tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, input_tensor.data(), input_tensor.size(), input_shape.data(), input_shape.size()));
-        input_tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, state_ptr->state.data(), state_ptr->state.size(), state_shape.data(), state_shape.size()));
-        input_tensors.push_back(Ort::Value::CreateTensor<int64_t>(memory_info_, state_ptr->sr.data(), state_ptr->sr.size(), sr_shape.data(), sr_shape.size()));
+    float VADEngine::Process(const std::shared_ptr<VADSessionState>& state_ptr, PcmView pcm_data) {
+        if (!session_ || !state_ptr || !state_ptr->binding[state_ptr->current]) return 0.0f;
+        if (pcm_data.size != VAD_CHUNK_SIZE) {
+            if (debug_) std::cerr << "[VAD] Expected " << VAD_CHUNK_SIZE << " samples, got " << pcm_data.size << std::endl;
+            return 0.0f;
+        }
 
-        // 4. Run Inference
-        const char* input_names[] = {"input", "state", "sr"};
-        const char* output_names[] = {"output", "stateN"};
+        // 1. Prepare Input (Normalize Int16 -> Float32) into the bound input buffer
+        dsp::Int16ToFloat(pcm_data.data, state_ptr->input.data(), VAD_CHUNK_SIZE);
 
+        // 2. Run Inference: state[current] -> stateN in state[1 - current], prob in place
         try {
-            auto output_tensors = session_->Run(
-                Ort::RunOptions{nullptr}, 
-                input_names, input_tensors.data(), 3, 
-                output_names, 2
-            );
-
-            // 5. Update State (stateN -> state)
-            float* new_state_data = output_tensors[1].GetTensorMutableData<float>();
-            std::memcpy(state_ptr->state.data(), new_state_data, state_ptr->state.size() * sizeof(float));
-
-            // 6. Get Probability (output is [1, 2], we want output[0][1] for speech)
-            // But V5 output shape is [1, N] actually containing probabilities?
-            // Actually V5 standard: output is [1, 1] prob? No, usually [1, batch].
-            // Let's assume standard Silero [1, 1] output for prob.
-            
-            float* output_data = output_tensors[0].GetTensorMutableData<float>();
-            return output_data[0]; 
+            session_->Run(run_options_, *state_ptr->binding[state_ptr->current]);
+            state_ptr->current ^= 1;
+            return state_ptr->prob;
 
         } catch (const std::exception& e) {
             if (debug_) std::cerr << "[VAD] Run Error: " << e.what() << std::endl;
             return 0.0f;
         }
     }
+
+    bool VADEngine::ProcessBatch(VADBatch& batch) {
+        const size_t batch_size = batch.Size();
+        if (!session_ || batch_size == 0 || batch_size > batch.Capacity()) return false;
+
+        // 1. Stack per-stream state [2, 1, 128] -> [2, B, 128]
+        for (size_t b = 0; b < batch_size; ++b) {
+            const float* src = batch.states[b]->State();
+            for (size_t layer = 0; layer < 2; ++layer) {
+                std::memcpy(&batch.state[(layer * batch_size + b) * VAD_STATE_DIM],
+                            &src[layer * VAD_STATE_DIM],
+                            VAD_STATE_DIM * sizeof(float));
+            }
+        }
+
+        try {
+            // 2. Tensors for this batch size are built once, then reused
+            std::vector<Ort::Value>& tensors = batch.tensors[batch_size];
+            if (tensors.empty()) {
+                int64_t b = static_cast<int64_t>(batch_size);
+                int64_t input_shape[] = {b, static_cast<int64_t>(VAD_CHUNK_SIZE)};
+                int64_t state_shape[] = {2, b, static_cast<int64_t>(VAD_STATE_DIM)};
+                int64_t sr_shape[] = {1};
+                int64_t prob_shape[] = {b, 1};
+
+                tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, batch.input.data(), batch_size * VAD_CHUNK_SIZE, input_shape, 2));
+                tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, batch.state.data(), batch_size * VAD_STATE_SIZE, state_shape, 3));
+                tensors.push_back(Ort::Value::CreateTensor<int64_t>(memory_info_, &batch.sr, 1, sr_shape, 1));
+                tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, batch.probs.data(), batch_size, prob_shape, 2));
+                tensors.push_back(Ort::Value::CreateTensor<float>(memory_info_, batch.state_out.data(), batch_size * VAD_STATE_SIZE, state_shape, 3));
+            }
+
+            session_->Run(run_options_,
+                          INPUT_NAMES, tensors.data(), 3,
+                          OUTPUT_NAMES, tensors.data() + 3, 2);
+
+            // 3. Scatter stateN [2, B, 128] back into each stream's current state
+            for (size_t b = 0; b < batch_size; ++b) {
+                float* dst = batch.states[b]->State();
+                for (size_t layer = 0; layer < 2; ++layer) {
+                    std::memcpy(&dst[layer * VAD_STATE_DIM],
+                                &batch.state_out[(layer * batch_size + b) * VAD_STATE_DIM],
+                                VAD_STATE_DIM * sizeof(float));
+                }
+            }
+            return true;
+
+        } catch (const std::exception& e) {
+            if (debug_) std::cerr << "[VAD] Batch Run Error: " << e.what() << std::endl;
+            return false;
+        }
+    }
 }
@@ -3,14 +3,52 @@
 #include <vector>
 #include <memory>
 #include <onnxruntime_cxx_api.h>
+#include "BoWWServerDefs.h"
 
 namespace boww {
 
+    constexpr int VAD_SAMPLE_RATE = 16000;      // Rate the model runs at; groups resample to it
+    constexpr size_t VAD_CHUNK_SIZE = 512;      // Silero V5 window at 16 kHz
+    constexpr size_t VAD_STATE_DIM = 128;       // State shape: [2, batch, 128]
+    constexpr size_t VAD_STATE_SIZE = 2 * VAD_STATE_DIM;
+
     // Helper struct to hold state per-session
     struct VADSessionState {
-        // Silero V5 state shape: [2, 1, 128]
-        std::vector<float> state;
+        // Silero V5 state shape: [2, 1, 128], double-buffered.
+        // A run reads state[current] and writes stateN into the other half, then flips.
+        std::vector<float> state[2];
+        int current = 0;
         std::vector<int64_t> sr; // Sample Rate container
+
+        // Persistent I/O: normalized input chunk and output probability ([1, 1])
+        std::vector<float> input;
+        float prob = 0.0f;
+
+        // Tensors over the buffers above, pre-bound once per ping-pong parity
+        std::vector<Ort::Value> tensors;
+        std::unique_ptr<Ort::IoBinding> binding[2];
+
+        float* State() { return state[current].data(); }
+    };
+
+    // Scratch for one stacked inference call over several independent streams.
+    // Owned by the thread that drives batches, so Reserve() once and reuse.
+    struct VADBatch {
+        std::vector<VADSessionState*> states;   // [B]
+        std::vector<float> input;               // [max B, VAD_CHUNK_SIZE], normalized
+        std::vector<float> state;               // [2, B, 128]
+        std::vector<float> state_out;           // [2, B, 128]
+        std::vector<float> probs;               // [B] results
+        int64_t sr = VAD_SAMPLE_RATE;
+
+        // Tensors over the buffers above, built lazily per batch size B (3 inputs, 2 outputs)
+        std::vector<std::vector<Ort::Value>> tensors;
+
+        void Reserve(size_t max_batch);
+        void Clear();
+        void Add(VADSessionState* s, const float* chunk);
+        size_t Size() const { return states.size(); }
+        size_t Capacity() const { return probs.size(); }
     };
 
     class VADEngine {
@@ -20,8 +58,13 @@ namespace boww {
 
         bool Initialize(const std::string& model_path);
         
-        // Returns probability 0.0 - 1.0
-        float Process(std::shared_ptr<VADSessionState> state, const std::vector<int16_t>& pcm_data);
+        // Returns probability 0.0 - 1.0. Expects VAD_CHUNK_SIZE samples.
+        // Runs over the session's pre-bound buffers: no heap allocation per call.
+        float Process(const std::shared_ptr<VADSessionState>& state, PcmView pcm_data);
+
+        // One [B, N] run over B streams; fills batch.probs and advances every state.
+        // Each state may appear at most once per batch.
+        bool ProcessBatch(VADBatch& batch);
 
         // Factory for per-client state
         std::shared_ptr<VADSessionState> CreateSessionState();
@@ -31,5 +74,6 @@ namespace boww {
         Ort::Env env_;
         std::unique_ptr<Ort::Session> session_;
         Ort::MemoryInfo memory_info_;
+        Ort::RunOptions run_options_;
     };
 }
@@ -0,0 +1,188 @@
+#include "VADScheduler.h"
+#include "GroupController.h"
+#include "DSPKernels.h"
+#include <iostream>
+#include <algorithm>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace boww {
+
+    // Pins the calling thread; workers take cores from the top down, away from the
+    // asio threads that the kernel tends to start on the low cores
+    static bool PinToCore(int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    VADScheduler::VADScheduler(VADEngine& engine, int max_batch, int deadline_us, int workers, int max_queued)
+        : engine_(engine),
+          max_batch_(static_cast<size_t>(std::max(1, max_batch))),
+          deadline_(std::max(0, deadline_us)),
+          max_queued_(static_cast<size_t>(std::max(1, max_queued)))
+    {
+        int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        int count = workers > 0 ? workers : cores;
+        pending_.reserve(max_batch_ * 4);
+        busy_.reserve(max_batch_ * count);
+        for (int i = 0; i < count; ++i) {
+            auto worker = std::make_unique<Worker>();
+            worker->cpu = (cores - 1 - i % cores);
+            worker->in_flight.reserve(max_batch_);
+            worker->batch.Reserve(max_batch_);
+            workers_.push_back(std::move(worker));
+        }
+    }
+
+    VADScheduler::~VADScheduler() {
+        Stop();
+    }
+
+    void VADScheduler::Start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) return;
+        running_ = true;
+        for (auto& worker : workers_) {
+            worker->thread = std::thread(&VADScheduler::WorkerLoop, this, std::ref(*worker));
+        }
+        std::cout << "[VAD] Scheduler started: " << workers_.size() << " worker(s), max batch " << max_batch_
+                  << ", deadline " << deadline_.count() << "us, " << max_queued_ << " chunks queued per stream" << std::endl;
+    }
+
+    void VADScheduler::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+        pending_.clear();
+        busy_.clear();
+        queue_depth_.store(0, std::memory_order_relaxed);
+    }
+
+    bool VADScheduler::Submit(std::shared_ptr<GroupController> group,
+                              std::shared_ptr<ClientSession> session,
+                              std::shared_ptr<VADSessionState> state,
+                              const int16_t* pcm) {
+        if (!state) return false;
+
+        Job job;
+        job.group = std::move(group);
+        job.session = std::move(session);
+        job.state = std::move(state);
+        job.queued_at = std::chrono::steady_clock::now();
+        dsp::Int16ToFloat(pcm, job.input.data(), VAD_CHUNK_SIZE);
+
+        bool shed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return false;
+
+            // Shed this stream's oldest chunk once it has max_queued_ waiting; the newest
+            // audio is what endpointing needs, and other rooms keep their place in line
+            size_t queued = 0;
+            auto oldest = pending_.end();
+            for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+                if (it->state != job.state) continue;
+                if (queued++ == 0) oldest = it;
+            }
+            if (queued >= max_queued_) {
+                pending_.erase(oldest);
+                shed = true;
+            }
+            pending_.push_back(std::move(job));
+            queue_depth_.store(pending_.size(), std::memory_order_relaxed);
+        }
+        cv_.notify_one();
+        return !shed;
+    }
+
+    bool VADScheduler::IsBusy(const VADSessionState* state) const {
+        return std::find(busy_.begin(), busy_.end(), state) != busy_.end();
+    }
+
+    bool VADScheduler::BatchReady(std::chrono::steady_clock::time_point now) const {
+        // Only chunks a worker could take right now count: not already in another batch
+        size_t distinct = 0;
+        bool any = false;
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            if (IsBusy(pending_[i].state.get())) continue;
+            if (!any && now - pending_[i].queued_at >= deadline_) return true;
+            any = true;
+            bool seen = false;
+            for (size_t j = 0; j < i && !seen; ++j) seen = (pending_[j].state == pending_[i].state);
+            if (!seen) distinct++;
+        }
+        if (!any) return false;
+
+        int idle_streams = active_streams_.load() - static_cast<int>(busy_.size());
+        size_t expected = static_cast<size_t>(std::max(1, idle_streams));
+        return distinct >= std::min(max_batch_, expected);
+    }
+
+    void VADScheduler::WorkerLoop(Worker& worker) {
+        if (workers_.size() > 1 && !PinToCore(worker.cpu)) {
+            std::cerr << "[VAD] Could not pin worker to core " << worker.cpu << std::endl;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (running_) {
+            auto now = std::chrono::steady_clock::now();
+            if (!BatchReady(now)) {
+                // Sleep until the oldest takeable chunk's deadline, or until a submit or
+                // another worker finishing changes the picture
+                auto first = std::find_if(pending_.begin(), pending_.end(),
+                    [this](const Job& j) { return !IsBusy(j.state.get()); });
+                if (first == pending_.end()) cv_.wait(lock);
+                else cv_.wait_until(lock, first->queued_at + deadline_);
+                continue;
+            }
+
+            // Gather FIFO, at most one chunk per stream and none already in flight elsewhere
+            for (auto it = pending_.begin(); it != pending_.end() && worker.in_flight.size() < max_batch_;) {
+                if (IsBusy(it->state.get())) { ++it; continue; }
+                busy_.push_back(it->state.get());
+                worker.in_flight.push_back(std::move(*it));
+                it = pending_.erase(it);
+            }
+            queue_depth_.store(pending_.size(), std::memory_order_relaxed);
+            bool more = !pending_.empty();
+            lock.unlock();
+            if (more) cv_.notify_one();     // Another worker may be able to take the rest
+
+            worker.batch.Clear();
+            for (auto& job : worker.in_flight) worker.batch.Add(job.state.get(), job.input.data());
+            bool ok = engine_.ProcessBatch(worker.batch);
+            auto done = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < worker.in_flight.size(); ++i) {
+                auto latency = std::chrono::duration_cast<std::chrono::microseconds>(done - worker.in_flight[i].queued_at);
+                worker.in_flight[i].group->OnVADResult(worker.in_flight[i].session, ok ? worker.batch.probs[i] : 0.0f, latency.count());
+            }
+
+            lock.lock();
+            for (auto& job : worker.in_flight) {
+                busy_.erase(std::find(busy_.begin(), busy_.end(), job.state.get()));
+            }
+            lock.unlock();
+            worker.in_flight.clear();   // Drops group/session refs outside the lock
+            lock.lock();
+            if (!pending_.empty()) cv_.notify_all();    // Freed streams may unblock other workers
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BoWWServerDefs.h"
+#include "VADEngine.h"
+
+namespace boww {
+
+    class GroupController;
+    class ClientSession;
+
+    // Collects ready 512-sample chunks from all LOCKED groups and runs them as stacked
+    // Silero calls on a fixed pool of inference threads, each pinned to a core and owning
+    // its own batch scratch. A worker dispatches as soon as every idle stream has a chunk
+    // queued, the batch is full, or the oldest chunk hits the deadline. A stream is only
+    // ever in one worker's batch at a time, so its recurrent state advances in order.
+    // Results go back to the owning group via GroupController::OnVADResult.
+    //
+    // Submit never waits on inference. Each stream may have at most max_queued chunks
+    // waiting; past that its oldest chunk is shed, so a backed-up room cannot grow the
+    // queue for everyone else.
+    class VADScheduler {
+    public:
+        VADScheduler(VADEngine& engine, int max_batch = 8, int deadline_us = 2000, int workers = 1, int max_queued = 8);
+        ~VADScheduler();
+
+        void Start();
+        void Stop();
+
+        // Converts the chunk to float now (on the caller's strand) and queues it.
+        // Returns false if a chunk was shed to make room (or the scheduler is stopped).
+        bool Submit(std::shared_ptr<GroupController> group,
+                    std::shared_ptr<ClientSession> session,
+                    std::shared_ptr<VADSessionState> state,
+                    const int16_t* pcm);
+
+        // Number of streams currently feeding chunks; lets batches close early
+        void AddStream() { active_streams_++; }
+        void RemoveStream() { active_streams_--; }
+
+        VADEngine& GetEngine() { return engine_; }
+        size_t GetWorkerCount() const { return workers_.size(); }
+        size_t GetQueueDepth() const { return queue_depth_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Job {
+            std::shared_ptr<GroupController> group;
+            std::shared_ptr<ClientSession> session;
+            std::shared_ptr<VADSessionState> state;
+            std::chrono::steady_clock::time_point queued_at;
+            std::array<float, VAD_CHUNK_SIZE> input;
+        };
+
+        // Per-thread scratch; touched without the lock only by its own thread
+        struct Worker {
+            std::thread thread;
+            int cpu = -1;
+            std::vector<Job> in_flight;
+            VADBatch batch;
+        };
+
+        VADEngine& engine_;
+        size_t max_batch_;
+        std::chrono::microseconds deadline_;
+        size_t max_queued_;
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<Job> pending_;
+        std::vector<VADSessionState*> busy_;    // States in some worker's batch right now
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::atomic<int> active_streams_{0};
+        std::atomic<size_t> queue_depth_{0};
+
+        bool running_ = false;
+
+        void WorkerLoop(Worker& worker);
+        bool IsBusy(const VADSessionState* state) const;
+        bool BatchReady(std::chrono::steady_clock::time_point now) const;
+    };
+}
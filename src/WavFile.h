@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace boww {
+
+    // 16-bit PCM WAV reader shared by --replay and boww_loadgen. Every chunk is checked
+    // against the file size before its body is read; a data chunk that runs past the end
+    // (a recording that was never closed) is truncated. Samples are trimmed to whole frames.
+    inline bool LoadWav(const std::string& path, std::vector<int16_t>& samples, int& sample_rate, int& channels, std::string& error) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "cannot open file";
+            return false;
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0 || std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+            error = "not a RIFF/WAVE file";
+            return false;
+        }
+
+        int bits = 0;
+        bool have_fmt = false, have_data = false;
+        for (size_t pos = 12; pos + 8 <= bytes.size();) {
+            uint32_t len;
+            std::memcpy(&len, bytes.data() + pos + 4, 4);
+            const char* body = bytes.data() + pos + 8;
+            const size_t available = bytes.size() - pos - 8;
+            if (std::memcmp(bytes.data() + pos, "fmt ", 4) == 0) {
+                if (len < 16 || len > available) {
+                    error = "truncated fmt chunk";
+                    return false;
+                }
+                uint16_t format, ch, bps;
+                uint32_t rate;
+                std::memcpy(&format, body, 2);
+                std::memcpy(&ch, body + 2, 2);
+                std::memcpy(&rate, body + 4, 4);
+                std::memcpy(&bps, body + 14, 2);
+                if (format != 1 && format != 0xFFFE) bits = 0;      // PCM or WAVE_FORMAT_EXTENSIBLE
+                else bits = bps;
+                channels = ch;
+                sample_rate = static_cast<int>(std::min<uint32_t>(rate, INT32_MAX));
+                have_fmt = true;
+            } else if (std::memcmp(bytes.data() + pos, "data", 4) == 0) {
+                size_t n = std::min<size_t>(len, available) / sizeof(int16_t);
+                samples.resize(n);
+                if (n > 0) std::memcpy(samples.data(), body, n * sizeof(int16_t));
+                have_data = true;
+            }
+            if (len >= available) break;
+            pos += 8 + static_cast<size_t>(len) + (len & 1);
+        }
+
+        if (!have_fmt || !have_data) {
+            error = have_fmt ? "no data chunk" : "no fmt chunk";
+            return false;
+        }
+        if (bits != 16 || channels < 1 || sample_rate <= 0) {
+            error = "need 16-bit PCM";
+            return false;
+        }
+        samples.resize(samples.size() - samples.size() % static_cast<size_t>(channels));
+        return true;
+    }
+}
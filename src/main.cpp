@@ -1,14 +1,53 @@
 #include "BoWWServer.h"
+#include "Replay.h"
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
 
 int main(int argc, char* argv[]) {
-    bool debug = false;
-    if (argc > 1 && strcmp(argv[1], "--debug") == 0) {
-        debug = true;
+    boww::ServerOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--debug") == 0) {
+            options.debug_mode = true;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.io_threads = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--vad-batch") == 0 && i + 1 < argc) {
+            options.vad_max_batch = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--vad-deadline-us") == 0 && i + 1 < argc) {
+            options.vad_batch_deadline_us = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--vad-workers") == 0 && i + 1 < argc) {
+            options.vad_workers = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--vad-queue") == 0 && i + 1 < argc) {
+            options.vad_max_queued = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.replay_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay-group") == 0 && i + 1 < argc) {
+            options.replay_group = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay-jobs") == 0 && i + 1 < argc) {
+            options.replay_jobs = std::atoi(argv[++i]);
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--debug] [--threads N] [--vad-batch N] [--vad-deadline-us US]"
+                      << " [--vad-workers N] [--vad-queue N]\n"
+                      << "       " << argv[0] << " --replay <file.wav|dir> [--replay-group NAME] [--replay-jobs N]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.replay_path.empty()) {
+        return boww::RunReplay(options);
     }
 
-    boww::BoWWServer server(debug);
+    boww::BoWWServer server(options);
     server.Run(9002);
     return 0;
 }
@@ -0,0 +1,563 @@
+// boww_loadgen: opens N WebSocket clients against a running server, runs the
+// hello -> confidence -> stream protocol with every one of them and reports latencies.
+//
+//   ./boww_loadgen --clients 16 --wav ../jfk-sil.wav --speed 1 --score uniform:0.5:1.0
+//
+// GUIDs are taken from clients.yaml (round-robin) unless given with --guid.
+// Server CPU and frame drop counts come from the server's /metrics endpoint.
+// --binary and --codec adpcm|opus exercise the negotiated binary framing and compressed ingest.
+
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+#include <nlohmann/json.hpp>
+#include <yaml-cpp/yaml.h>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BoWWServerDefs.h"
+#include "BinaryProtocol.h"
+#include "AudioDecoder.h"
+#include "WavFile.h"
+
+#ifdef BOWW_HAVE_OPUS
+    #include <opus/opus.h>
+#endif
+
+namespace {
+
+    using Client = websocketpp::client<websocketpp::config::asio_client>;
+    using Clock = std::chrono::steady_clock;
+    using Timer = websocketpp::lib::asio::steady_timer;
+
+    struct Options {
+        std::string host = "127.0.0.1";
+        int port = 9002;
+        int clients = 4;
+        std::string config = "../clients.yaml";
+        std::vector<std::string> guids;
+        std::string wav = "../jfk-sil.wav";
+        size_t frame_samples = 1024;
+        double speed = 1.0;             // 0 = as fast as the socket takes it
+        std::string score = "fixed:1.0";
+        int stagger_ms = 0;             // Confidence sends spread uniformly over this window
+        int stop_timeout_ms = 10000;    // Wait for the server's stop after the file ends
+        unsigned seed = 1;
+        bool binary = false;            // Negotiate the framed binary protocol instead of JSON control
+        boww::IngestCodec codec = boww::IngestCodec::PCM16;
+    };
+
+#ifdef BOWW_HAVE_OPUS
+    struct OpusEncoderDeleter {
+        void operator()(OpusEncoder* enc) const { opus_encoder_destroy(enc); }
+    };
+#endif
+
+    struct Wav {
+        std::vector<int16_t> samples;
+        int sample_rate = 16000;
+        int channels = 1;
+        size_t last_voice_sample = 0;   // End of the last loud frame (simple energy gate)
+    };
+
+    struct Stream {
+        size_t index = 0;
+        std::string guid;
+        float score = 1.0f;
+        websocketpp::connection_hdl hdl;
+        std::unique_ptr<Timer> timer;
+
+        Clock::time_point t_open, t_conf, t_ack, t_voice_end, t_stop;
+        bool acked = false;
+        bool stopped = false;
+        bool done = false;
+        bool failed = false;
+        bool eof = false;
+        size_t next_sample = 0;
+        size_t frames_sent = 0;
+        uint32_t seq = 0;
+        std::vector<uint8_t> frame;     // Header + PCM scratch for binary mode
+        size_t bytes_sent = 0;          // Audio payload only
+
+        boww::IngestCodec codec = boww::IngestCodec::PCM16;     // What hello_ack granted
+        boww::adpcm::EncoderState adpcm;
+        std::vector<uint8_t> encoded;
+#ifdef BOWW_HAVE_OPUS
+        std::unique_ptr<OpusEncoder, OpusEncoderDeleter> opus;
+        std::vector<int16_t> opus_pad;  // Short last frame, zero-padded to the frame size
+#endif
+    };
+
+    double Ms(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+    bool LoadWav(const std::string& path, Wav& wav, std::string& error) {
+        if (!boww::LoadWav(path, wav.samples, wav.sample_rate, wav.channels, error)) return false;
+        if (wav.samples.empty()) {
+            error = "no audio";
+            return false;
+        }
+
+        // Last 32ms frame above ~-40 dBFS marks where speech ends
+        const size_t frame = static_cast<size_t>(wav.sample_rate * wav.channels) * 32 / 1000;
+        for (size_t i = 0; frame > 0 && i + frame <= wav.samples.size(); i += frame) {
+            double sum = 0;
+            for (size_t j = i; j < i + frame; ++j) sum += static_cast<double>(wav.samples[j]) * wav.samples[j];
+            if (std::sqrt(sum / frame) > 330.0) wav.last_voice_sample = i + frame;
+        }
+        return true;
+    }
+
+    // score spec: fixed:V | uniform:LO:HI | normal:MEAN:STDDEV
+    std::function<float(std::mt19937&)> MakeScoreDist(const std::string& spec) {
+        std::vector<double> args;
+        std::string kind = spec.substr(0, spec.find(':'));
+        for (size_t pos = spec.find(':'); pos != std::string::npos; pos = spec.find(':', pos + 1)) {
+            args.push_back(std::atof(spec.c_str() + pos + 1));
+        }
+        if (kind == "uniform" && args.size() == 2) {
+            return [lo = args[0], hi = args[1]](std::mt19937& rng) {
+                return static_cast<float>(std::uniform_real_distribution<double>(lo, hi)(rng));
+            };
+        }
+        if (kind == "normal" && args.size() == 2) {
+            return [mean = args[0], dev = args[1]](std::mt19937& rng) {
+                return static_cast<float>(std::clamp(std::normal_distribution<double>(mean, dev)(rng), 0.0, 1.0));
+            };
+        }
+        if (kind == "fixed" && args.size() == 1) {
+            return [v = args[0]](std::mt19937&) { return static_cast<float>(v); };
+        }
+        return nullptr;
+    }
+
+    // Scrapes /metrics and sums every series of each family (all groups)
+    std::map<std::string, double> FetchMetrics(const std::string& host, int port) {
+        std::map<std::string, double> totals;
+        boost::asio::ip::tcp::iostream s(host, std::to_string(port));
+        if (!s) return totals;
+        s << "GET /metrics HTTP/1.0\r\nHost: " << host << "\r\n\r\n" << std::flush;
+
+        std::string line;
+        bool body = false;
+        while (std::getline(s, line)) {
+            if (!body) { body = (line == "\r" || line.empty()); continue; }
+            if (line.empty() || line[0] == '#') continue;
+            size_t name_end = line.find_first_of("{ ");
+            size_t value_pos = line.rfind(' ');
+            if (name_end == std::string::npos || value_pos == std::string::npos) continue;
+            totals[line.substr(0, name_end)] += std::atof(line.c_str() + value_pos + 1);
+        }
+        return totals;
+    }
+
+    void PrintStats(const char* label, std::vector<double> v) {
+        std::cout << "  " << std::left << std::setw(28) << label;
+        if (v.empty()) { std::cout << "n/a" << std::endl; return; }
+        std::sort(v.begin(), v.end());
+        auto pct = [&v](double p) { return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))]; };
+        std::cout << std::fixed << std::setprecision(2)
+                  << "n=" << v.size() << "  p50=" << pct(0.5) << "ms  p95=" << pct(0.95)
+                  << "ms  max=" << v.back() << "ms" << std::endl;
+    }
+
+    class LoadGen {
+    public:
+        LoadGen(const Options& opts, Wav wav) : opts_(opts), wav_(std::move(wav)), rng_(opts.seed) {}
+
+        bool Run() {
+            auto score_dist = MakeScoreDist(opts_.score);
+            if (!score_dist) {
+                std::cerr << "[LoadGen] Bad --score spec: " << opts_.score << std::endl;
+                return false;
+            }
+
+            client_.clear_access_channels(websocketpp::log::alevel::all);
+            client_.clear_error_channels(websocketpp::log::elevel::all);
+            client_.init_asio();
+
+            std::string uri = "ws://" + opts_.host + ":" + std::to_string(opts_.port);
+            streams_.resize(opts_.clients);
+            for (size_t i = 0; i < streams_.size(); ++i) {
+                Stream& s = streams_[i];
+                s.index = i;
+                s.guid = opts_.guids[i % opts_.guids.size()];
+                s.score = score_dist(rng_);
+                s.timer = std::make_unique<Timer>(client_.get_io_service());
+
+                websocketpp::lib::error_code ec;
+                auto con = client_.get_connection(uri, ec);
+                if (ec || !con) {
+                    std::cerr << "[LoadGen] Connection setup failed: " << ec.message() << std::endl;
+                    return false;
+                }
+                using websocketpp::lib::placeholders::_1;
+                using websocketpp::lib::placeholders::_2;
+                con->set_open_handler(websocketpp::lib::bind(&LoadGen::OnOpen, this, i, _1));
+                con->set_fail_handler(websocketpp::lib::bind(&LoadGen::OnFail, this, i, _1));
+                con->set_close_handler(websocketpp::lib::bind(&LoadGen::OnClose, this, i, _1));
+                con->set_message_handler(websocketpp::lib::bind(&LoadGen::OnMessage, this, i, _1, _2));
+                client_.connect(con);
+            }
+
+            std::cout << "[LoadGen] " << streams_.size() << " clients -> " << uri
+                      << " | frame " << opts_.frame_samples << " samples | " << (opts_.binary ? "binary" : "json")
+                      << " control | " << boww::IngestCodecName(opts_.codec) << " | speed "
+                      << (opts_.speed > 0 ? std::to_string(opts_.speed) + "x" : std::string("max")) << std::endl;
+
+            start_ = Clock::now();
+            client_.run();
+            end_ = Clock::now();
+            return true;
+        }
+
+        void Report(const std::map<std::string, double>& before, const std::map<std::string, double>& after) const {
+            std::vector<double> ack, decision, stop_after_voice;
+            size_t winners = 0, losers = 0, failed = 0, frames = 0, bytes = 0, samples = 0;
+            for (const auto& s : streams_) {
+                frames += s.frames_sent;
+                bytes += s.bytes_sent;
+                samples += s.next_sample;
+                if (s.failed) { failed++; continue; }
+                if (s.acked) ack.push_back(Ms(s.t_ack - s.t_conf));
+                bool voice_sent = s.t_voice_end != Clock::time_point();
+                if (s.stopped && voice_sent && s.t_stop >= s.t_voice_end) {
+                    winners++;
+                    stop_after_voice.push_back(Ms(s.t_stop - s.t_voice_end));
+                } else if (s.stopped) {
+                    losers++;
+                    decision.push_back(Ms(s.t_stop - s.t_conf));
+                }
+            }
+
+            double wall = std::chrono::duration<double>(end_ - start_).count();
+            std::cout << "\n[LoadGen] Results (" << std::fixed << std::setprecision(2) << wall << "s wall)" << std::endl;
+            std::cout << "  clients: " << streams_.size() << "  streamed to stop: " << winners
+                      << "  stopped early: " << losers << "  failed: " << failed << "  frames sent: " << frames << std::endl;
+            if (samples > 0) {
+                double kbps = 8.0 * bytes / (1000.0 * samples / wav_.sample_rate);
+                std::cout << "  audio payload: " << bytes / 1024 << " KiB, " << kbps << " kbit/s per stream ("
+                          << 100.0 * bytes / (samples * sizeof(int16_t)) << "% of PCM)" << std::endl;
+            }
+            PrintStats("confidence -> conf_rec", ack);
+            PrintStats("confidence -> stop (lost)", decision);
+            PrintStats("voice end -> stop (won)", stop_after_voice);
+
+            auto delta = [&](const char* name) {
+                auto a = after.find(name), b = before.find(name);
+                return (a == after.end() ? 0.0 : a->second) - (b == before.end() ? 0.0 : b->second);
+            };
+            if (after.empty()) {
+                std::cout << "  (server /metrics unavailable: no CPU or drop figures)" << std::endl;
+                return;
+            }
+            double cpu = delta("boww_process_cpu_seconds_total");
+            double received = delta("boww_frames_received_total");
+            double dropped = delta("boww_frames_dropped_total");
+            std::cout << "  server CPU: " << cpu << "s (" << (wall > 0 ? 100.0 * cpu / wall : 0.0) << "% of one core)" << std::endl;
+            // Seconds of audio the server took in per CPU second: realtime streams one core sustains.
+            // Compare runs at different server --threads to see how groups scale across cores.
+            double audio_s = static_cast<double>(samples) / (static_cast<double>(wav_.sample_rate) * wav_.channels);
+            auto threads = after.find("boww_io_threads");
+            std::cout << "  streams per core: " << (cpu > 0 ? audio_s / cpu : 0.0) << " (" << audio_s << "s of audio, "
+                      << (wall > 0 ? audio_s / wall : 0.0) << " streams in parallel, "
+                      << (threads == after.end() ? 0 : static_cast<int>(threads->second)) << " server I/O threads)" << std::endl;
+            std::cout << "  server frames: " << static_cast<uint64_t>(received) << " received, "
+                      << static_cast<uint64_t>(dropped) << " dropped ("
+                      << (received > 0 ? 100.0 * dropped / received : 0.0) << "%)" << std::endl;
+            std::cout << "  time to lock (server): " << 1000.0 * delta("boww_arbitration_duration_seconds_sum") /
+                         std::max(1.0, delta("boww_arbitration_duration_seconds_count")) << "ms mean over "
+                      << static_cast<uint64_t>(delta("boww_arbitration_duration_seconds_count")) << " arbitrations" << std::endl;
+            std::cout << "  timer wakeups (server): " << static_cast<uint64_t>(delta("boww_timer_wakeups_total")) << "  mean lateness: "
+                      << 1000.0 * delta("boww_timer_lateness_seconds_sum") / std::max(1.0, delta("boww_timer_lateness_seconds_count"))
+                      << "ms" << std::endl;
+            if (opts_.binary) {
+                std::cout << "  frames lost (server): " << static_cast<uint64_t>(delta("boww_frames_lost_total"))
+                          << "  mean jitter: " << 1000.0 * delta("boww_network_jitter_seconds_sum") /
+                             std::max(1.0, delta("boww_network_jitter_seconds_count")) << "ms" << std::endl;
+            }
+            std::cout << "  recording samples dropped: " << static_cast<uint64_t>(delta("boww_writer_dropped_samples_total")) << std::endl;
+        }
+
+    private:
+        Options opts_;
+        Wav wav_;
+        std::mt19937 rng_;
+        Client client_;
+        std::vector<Stream> streams_;
+        Clock::time_point start_, end_;
+
+        void Send(Stream& s, const nlohmann::json& j) {
+            websocketpp::lib::error_code ec;
+            client_.send(s.hdl, j.dump(), websocketpp::frame::opcode::text, ec);
+        }
+
+        // Header + payload as one binary frame
+        void SendBinary(Stream& s, boww::Binary::Type type, const void* payload, size_t bytes, websocketpp::lib::error_code& ec) {
+            boww::Binary::Header header;
+            header.type = type;
+            header.seq = s.seq++;
+            header.timestamp_us = boww::Binary::NowMicros();
+            s.frame.resize(boww::Binary::HEADER_SIZE + bytes);
+            boww::Binary::Encode(header, s.frame.data());
+            if (bytes) std::memcpy(s.frame.data() + boww::Binary::HEADER_SIZE, payload, bytes);
+            client_.send(s.hdl, s.frame.data(), s.frame.size(), websocketpp::frame::opcode::binary, ec);
+        }
+
+        void OnOpen(size_t i, websocketpp::connection_hdl hdl) {
+            Stream& s = streams_[i];
+            s.hdl = hdl;
+            s.t_open = Clock::now();
+            nlohmann::json hello = {{"type", boww::Protocol::MSG_HELLO}, {"guid", s.guid}};
+            if (opts_.codec != boww::IngestCodec::PCM16) hello["codecs"] = {boww::IngestCodecName(opts_.codec)};
+            if (opts_.binary) hello["binary"] = 1;
+            if (opts_.binary || opts_.codec != boww::IngestCodec::PCM16) {
+                Send(s, hello);
+                return;     // Confidence goes out once hello_ack confirms framing and codec
+            }
+            Send(s, hello);
+            ScheduleConfidence(i);
+        }
+
+        void ScheduleConfidence(size_t i) {
+            Stream& s = streams_[i];
+            int delay = opts_.stagger_ms > 0 ? std::uniform_int_distribution<int>(0, opts_.stagger_ms)(rng_) : 0;
+            s.timer->expires_after(std::chrono::milliseconds(delay));
+            s.timer->async_wait([this, i](const auto& ec) {
+                if (ec) return;
+                Stream& st = streams_[i];
+                st.t_conf = Clock::now();
+                if (opts_.binary) {
+                    websocketpp::lib::error_code send_ec;
+                    SendBinary(st, boww::Binary::Type::CONFIDENCE, &st.score, sizeof(float), send_ec);
+                } else {
+                    Send(st, {{"type", boww::Protocol::MSG_CONFIDENCE}, {"value", st.score}});
+                }
+            });
+        }
+
+        void OnMessage(size_t i, websocketpp::connection_hdl, Client::message_ptr msg) {
+            Stream& s = streams_[i];
+            std::string type;
+            nlohmann::json j;
+            if (msg->get_opcode() == websocketpp::frame::opcode::binary) {
+                boww::Binary::Header header;
+                const std::string& payload = msg->get_payload();
+                if (!boww::Binary::Decode(payload.data(), payload.size(), header)) return;
+                if (header.type == boww::Binary::Type::CONF_REC) type = boww::Protocol::MSG_CONF_REC;
+                else if (header.type == boww::Binary::Type::STOP) type = boww::Protocol::MSG_STOP;
+                else return;
+            } else {
+                j = nlohmann::json::parse(msg->get_payload(), nullptr, false);
+                if (j.is_discarded() || !j.contains("type")) return;
+                type = j["type"];
+            }
+
+            if (type == boww::Protocol::MSG_HELLO_ACK) {
+                // Server may not offer the codec (e.g. no libopus): fall back to whatever it granted
+                if (!j.contains("codec") || !j["codec"].is_string() || !boww::ParseIngestCodec(j["codec"].get<std::string>(), s.codec)) {
+                    s.codec = boww::IngestCodec::PCM16;
+                }
+                // Compressed frames are decoded at the group's format, so the WAV has to match it
+                if (s.codec != boww::IngestCodec::PCM16 &&
+                    (j.value("sample_rate", wav_.sample_rate) != wav_.sample_rate || j.value("channels", wav_.channels) != wav_.channels)) {
+                    std::cerr << "[LoadGen] Group expects " << j.value("sample_rate", 0) << " Hz x" << j.value("channels", 0)
+                              << "; the WAV is " << wav_.sample_rate << " Hz x" << wav_.channels << "." << std::endl;
+                    s.failed = true;
+                    Finish(s);
+                    return;
+                }
+                if (!InitEncoder(s)) { s.failed = true; Finish(s); return; }
+                ScheduleConfidence(i);
+            }
+            else if (type == boww::Protocol::MSG_CONF_REC && !s.acked) {
+                s.acked = true;
+                s.t_ack = Clock::now();
+                SendNextFrame(i, s.t_ack);
+            }
+            else if (type == boww::Protocol::MSG_STOP && !s.stopped) {
+                s.stopped = true;
+                s.t_stop = Clock::now();
+                Finish(s);
+            }
+        }
+
+        void OnFail(size_t i, websocketpp::connection_hdl) {
+            streams_[i].failed = true;
+            streams_[i].done = true;
+            streams_[i].timer->cancel();
+        }
+
+        void OnClose(size_t i, websocketpp::connection_hdl) {
+            streams_[i].done = true;
+            streams_[i].timer->cancel();
+        }
+
+        // Paced against an absolute schedule so timer slop does not accumulate
+        void SendNextFrame(size_t i, Clock::time_point due) {
+            Stream& s = streams_[i];
+            if (s.done || s.stopped) return;
+
+            if (s.next_sample >= wav_.samples.size()) {
+                s.eof = true;
+                s.timer->expires_after(std::chrono::milliseconds(opts_.stop_timeout_ms));
+                s.timer->async_wait([this, i](const auto& ec) { if (!ec) Finish(streams_[i]); });
+                return;
+            }
+
+            size_t n = std::min(opts_.frame_samples, wav_.samples.size() - s.next_sample);
+            const void* payload = wav_.samples.data() + s.next_sample;
+            size_t bytes = n * sizeof(int16_t);
+            if (s.codec != boww::IngestCodec::PCM16) {
+                if (!Encode(s, wav_.samples.data() + s.next_sample, n)) { s.failed = true; Finish(s); return; }
+                payload = s.encoded.data();
+                bytes = s.encoded.size();
+            }
+
+            websocketpp::lib::error_code ec;
+            if (opts_.binary) {
+                SendBinary(s, boww::Binary::Type::AUDIO, payload, bytes, ec);
+            } else {
+                client_.send(s.hdl, payload, bytes, websocketpp::frame::opcode::binary, ec);
+            }
+            if (ec) { s.failed = true; Finish(s); return; }
+            s.bytes_sent += bytes;
+
+            size_t before = s.next_sample;
+            s.next_sample += n;
+            s.frames_sent++;
+            if (before < wav_.last_voice_sample && s.next_sample >= wav_.last_voice_sample) s.t_voice_end = Clock::now();
+
+            if (opts_.speed > 0) {
+                double frame_s = static_cast<double>(n) / (wav_.sample_rate * wav_.channels) / opts_.speed;
+                due += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frame_s));
+            } else {
+                due = Clock::now();
+            }
+            s.timer->expires_at(due);
+            s.timer->async_wait([this, i, due](const auto& ec) { if (!ec) SendNextFrame(i, due); });
+        }
+
+        bool InitEncoder(Stream& s) {
+            if (s.codec != boww::IngestCodec::OPUS) return true;
+#ifdef BOWW_HAVE_OPUS
+            int err = OPUS_OK;
+            s.opus.reset(opus_encoder_create(wav_.sample_rate, wav_.channels, OPUS_APPLICATION_VOIP, &err));
+            if (err != OPUS_OK) s.opus.reset();
+            return s.opus != nullptr;
+#else
+            std::cerr << "[LoadGen] Server granted opus but this build has no libopus." << std::endl;
+            return false;
+#endif
+        }
+
+        // One codec frame per WebSocket frame, into s.encoded
+        bool Encode(Stream& s, const int16_t* pcm, size_t n) {
+            if (s.codec == boww::IngestCodec::IMA_ADPCM) {
+                s.encoded.resize(boww::adpcm::EncodedSize(n));
+                s.encoded.resize(boww::adpcm::Encode(pcm, n, s.encoded.data(), s.adpcm));
+                return true;
+            }
+#ifdef BOWW_HAVE_OPUS
+            if (n < opts_.frame_samples) {
+                s.opus_pad.assign(pcm, pcm + n);
+                s.opus_pad.resize(opts_.frame_samples, 0);
+                pcm = s.opus_pad.data();
+            }
+            s.encoded.resize(1500);
+            int frame = static_cast<int>(opts_.frame_samples / wav_.channels);     // Opus counts per channel
+            int bytes = opus_encode(s.opus.get(), pcm, frame, s.encoded.data(), static_cast<opus_int32>(s.encoded.size()));
+            if (bytes < 0) return false;
+            s.encoded.resize(static_cast<size_t>(bytes));
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void Finish(Stream& s) {
+            if (s.done) return;
+            s.done = true;
+            s.timer->cancel();
+            websocketpp::lib::error_code ec;
+            client_.close(s.hdl, websocketpp::close::status::normal, "", ec);
+        }
+    };
+
+    std::vector<std::string> GuidsFromConfig(const std::string& path) {
+        std::vector<std::string> guids;
+        try {
+            YAML::Node config = YAML::LoadFile(path);
+            for (const auto& node : config["clients"]) guids.push_back(node["guid"].as<std::string>());
+        } catch (const YAML::Exception& e) {
+            std::cerr << "[LoadGen] Cannot read " << path << ": " << e.what() << std::endl;
+        }
+        return guids;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options opts;
+
+    for (int i = 1; i < argc; ++i) {
+        auto arg = [&](const char* name) { return strcmp(argv[i], name) == 0 && i + 1 < argc; };
+        if (arg("--host")) opts.host = argv[++i];
+        else if (arg("--port")) opts.port = std::atoi(argv[++i]);
+        else if (arg("--clients")) opts.clients = std::atoi(argv[++i]);
+        else if (arg("--config")) opts.config = argv[++i];
+        else if (arg("--guid")) opts.guids.push_back(argv[++i]);
+        else if (arg("--wav")) opts.wav = argv[++i];
+        else if (arg("--frame")) opts.frame_samples = static_cast<size_t>(std::atoi(argv[++i]));
+        else if (arg("--speed")) opts.speed = std::atof(argv[++i]);
+        else if (arg("--score")) opts.score = argv[++i];
+        else if (arg("--stagger-ms")) opts.stagger_ms = std::atoi(argv[++i]);
+        else if (arg("--stop-timeout-ms")) opts.stop_timeout_ms = std::atoi(argv[++i]);
+        else if (arg("--seed")) opts.seed = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (strcmp(argv[i], "--binary") == 0) opts.binary = true;
+        else if (arg("--codec") && boww::ParseIngestCodec(argv[i + 1], opts.codec)) ++i;
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--host H] [--port P] [--clients N] [--config clients.yaml] [--guid G]...\n"
+                      << "       [--wav FILE] [--frame SAMPLES] [--speed X (0 = max)] [--score fixed:V|uniform:LO:HI|normal:MEAN:SD]\n"
+                      << "       [--stagger-ms MS] [--stop-timeout-ms MS] [--seed N] [--binary] [--codec pcm|adpcm|opus]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Opus only takes 2.5-60 ms frames
+    if (opts.codec == boww::IngestCodec::OPUS && opts.frame_samples != 320 && opts.frame_samples != 640 && opts.frame_samples != 960) {
+        std::cout << "[LoadGen] Opus needs 20/40/60 ms frames; using --frame 320." << std::endl;
+        opts.frame_samples = 320;
+    }
+
+    if (opts.guids.empty()) opts.guids = GuidsFromConfig(opts.config);
+    if (opts.guids.empty() || opts.clients <= 0 || opts.frame_samples == 0) {
+        std::cerr << "[LoadGen] Need at least one client GUID (--guid or clients.yaml) and a non-zero frame size." << std::endl;
+        return 1;
+    }
+
+    Wav wav;
+    std::string error;
+    if (!LoadWav(opts.wav, wav, error)) {
+        std::cerr << "[LoadGen] " << opts.wav << ": " << error << "." << std::endl;
+        return 1;
+    }
+
+    auto before = FetchMetrics(opts.host, opts.port);
+    LoadGen gen(opts, std::move(wav));
+    if (!gen.Run()) return 1;
+    gen.Report(before, FetchMetrics(opts.host, opts.port));
+    return 0;
+}